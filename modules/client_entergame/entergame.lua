@@ -339,14 +339,19 @@ function EnterGame.doLogin()
     g_game.setProtocolVersion(g_game.getClientProtocolVersion(clientVersion))
     g_game.chooseRsa(G.host)
 
-    if modules.game_things.isLoaded() then
-        protocolLogin:login(G.host, G.port, G.account, G.password,
-                            G.authenticatorToken, G.stayLogged)
-    else
-        loadBox:destroy()
-        loadBox = nil
-        EnterGame.show()
-    end
+    -- things of a new client version are loaded in background
+    local waitingBox = loadBox
+    modules.game_things.whenLoaded(function()
+        if not loadBox or loadBox ~= waitingBox then return end
+        if modules.game_things.isLoaded() then
+            protocolLogin:login(G.host, G.port, G.account, G.password,
+                                G.authenticatorToken, G.stayLogged)
+        else
+            loadBox:destroy()
+            loadBox = nil
+            EnterGame.show()
+        end
+    end)
 end
 
 function EnterGame.displayMotd()
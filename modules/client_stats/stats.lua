@@ -3,6 +3,7 @@ HOST = 'otclient.herokuapp.com'
 PORT = 80
 FIRST_REPORT_DELAY = 15
 REPORT_DELAY = 60
+REPORT_OPCODES = 10
 
 sendReportEvent = nil
 firstReportEvent = nil
@@ -92,6 +93,7 @@ function onConnect(protocol)
     post = post .. '&cpu=' .. urlencode(g_platform.getCPUName())
     post = post .. '&mem=' .. g_platform.getTotalSystemMemory()
     post = post .. '&os_name=' .. urlencode(g_platform.getOSName())
+    post = post .. getProtocolData()
     post = post .. getAdditionalData()
 
     local message = ''
@@ -109,6 +111,48 @@ end
 
 function getAdditionalData() return '' end
 
+-- opcodes sorted by the client time they took, most expensive first
+function getSortedProtocolStats()
+    local stats = {}
+    for _, opcodeStats in pairs(g_game.getProtocolStats()) do
+        table.insert(stats, opcodeStats)
+    end
+    table.sort(stats, function(a, b) return a.totalTime > b.totalTime end)
+    return stats
+end
+
+function getProtocolData()
+    local opcodes = {}
+    for i, stats in ipairs(getSortedProtocolStats()) do
+        if i > REPORT_OPCODES then break end
+        table.insert(opcodes, string.format('%d:%d:%d:%d:%d', stats.opcode, stats.count, stats.bytes, stats.totalTime, stats.p99))
+    end
+
+    local data = ''
+    data = data .. '&protocol_packets=' .. g_game.getProtocolPacketCount()
+    data = data .. '&protocol_bytes=' .. g_game.getProtocolByteCount()
+    data = data .. '&protocol_slow_packets=' .. #g_game.getSlowPackets()
+    data = data .. '&protocol_opcodes=' .. urlencode(table.concat(opcodes, ';'))
+    return data
+end
+
+function printProtocolStats()
+    pinfo(string.format('%d packets, %d bytes', g_game.getProtocolPacketCount(), g_game.getProtocolByteCount()))
+    pinfo('opcode     count      bytes   total us   avg us    p50    p90    p99    max')
+    for _, stats in ipairs(getSortedProtocolStats()) do
+        pinfo(string.format('0x%02x %11d %10d %10d %8.1f %6d %6d %6d %6d', stats.opcode, stats.count, stats.bytes,
+                            stats.totalTime, stats.averageTime, stats.p50, stats.p90, stats.p99, stats.maxTime))
+    end
+
+    for _, packet in ipairs(g_game.getSlowPackets()) do
+        local opcodes = {}
+        for _, opcode in ipairs(packet.opcodes) do
+            table.insert(opcodes, string.format('0x%02x', opcode))
+        end
+        pinfo(string.format('slow packet: %d us, %d bytes, opcodes %s', packet.duration, packet.size, table.concat(opcodes, ' ')))
+    end
+end
+
 function onRecv(protocol, message)
     if string.find(message, 'HTTP/1.1 200 OK') then
         -- pinfo('Stats sent to server successfully!')
@@ -134,6 +134,22 @@ function ping()
     pinging = not pinging
 end
 
+function profile_lua(limit)
+    if g_luaProfiler.isEnabled() then
+        g_luaProfiler.setEnabled(false)
+        for _, line in ipairs(g_luaProfiler.getReport(limit or 20):split('\n')) do
+            pcolored(line)
+        end
+        if g_luaProfiler.dumpCollapsedStacks('lua_profile.folded') then
+            pcolored('Collapsed stacks saved to lua_profile.folded', 'green')
+        end
+    else
+        g_luaProfiler.reset()
+        g_luaProfiler.setEnabled(true)
+        pcolored('Lua profiler started, run profile_lua() again to stop it.')
+    end
+end
+
 function clear() modules.client_terminal.clear() end
 
 function ls(path)
@@ -13,6 +13,9 @@ LogWarning = 2
 LogError = 3
 LogFatal = 4
 
+UIEventPriority = 0
+BackgroundEventPriority = 1
+
 MouseFocusReason = 0
 KeyboardFocusReason = 1
 ActiveFocusReason = 2
@@ -1,14 +1,34 @@
 filename = nil
 loaded = false
+loadingPaths = nil
+loadedCallbacks = {}
 
-function init() connect(g_game, {onClientVersionChange = load}) end
+function init()
+    g_things.setDatCacheEnabled(true)
+    connect(g_game, {onClientVersionChange = load})
+    connect(g_things, {onAssetsLoaded = onAssetsLoaded})
+end
 
-function terminate() disconnect(g_game, {onClientVersionChange = load}) end
+function terminate()
+    disconnect(g_game, {onClientVersionChange = load})
+    disconnect(g_things, {onAssetsLoaded = onAssetsLoaded})
+end
 
 function setFileName(name) filename = name end
 
 function isLoaded() return loaded end
 
+function isLoading() return loadingPaths ~= nil end
+
+-- calls the callback once the things being loaded are ready, right away if nothing is loading
+function whenLoaded(callback)
+    if not isLoading() then
+        callback()
+        return
+    end
+    table.insert(loadedCallbacks, callback)
+end
+
 function load()
     local version = g_game.getClientVersion()
 
@@ -21,14 +41,25 @@ function load()
         sprPath = resolvepath('/things/' .. version .. '/Tibia')
     end
 
+    loaded = false
+    loadingPaths = {dat = datPath, spr = sprPath}
+    g_things.loadAssets(datPath, sprPath, '', '')
+end
+
+function onAssetsLoaded()
+    if not loadingPaths then return end
+
+    local datPath, sprPath = loadingPaths.dat, loadingPaths.spr
+    loadingPaths = nil
+
     local errorMessage = ''
-    if not g_things.loadDat(datPath) then
+    if not g_things.isDatLoaded() then
         errorMessage = errorMessage ..
                            tr(
                                "Unable to load dat file, please place a valid dat in '%s'",
                                datPath) .. '\n'
     end
-    if not g_sprites.loadSpr(sprPath) then
+    if not g_sprites.isLoaded() then
         errorMessage = errorMessage ..
                            tr(
                                "Unable to load spr file, please place a valid spr in '%s'",
@@ -49,4 +80,8 @@ function load()
         g_game.setProtocolVersion(0)
         connect(g_game, {onClientVersionChange = load})
     end
+
+    local callbacks = loadedCallbacks
+    loadedCallbacks = {}
+    for _, callback in ipairs(callbacks) do callback() end
 end
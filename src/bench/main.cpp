@@ -0,0 +1,417 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// otclient_bench: replays recorded sessions through ProtocolGame into g_map without a window or
+// GL context and reports the costs as JSON, so regressions can be tracked per commit
+
+#include <framework/core/application.h>
+#include <framework/core/clock.h>
+#include <framework/core/eventdispatcher.h>
+#include <framework/core/resourcemanager.h>
+#include <client/client.h>
+#include <client/game.h>
+#include <client/map/map.h>
+#include <client/manager/spritemanager.h>
+#include <client/manager/thingtypemanager.h>
+#include <client/manager/walkmanager.h>
+#include <client/protocol/packetgenerator.h>
+#include <client/protocol/packetplayer.h>
+#include <client/protocol/protocolgame.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+namespace
+{
+    std::atomic<uint64> s_allocations{ 0 };
+
+    struct RecordResult {
+        std::string file;
+        uint32 iterations{ 0 };
+        uint64 packets{ 0 };
+        uint64 bytes{ 0 };
+        uint32 recordedMillis{ 0 };
+        ticks_t wallMicros{ 0 };
+        ticks_t parseMicros{ 0 };
+        ticks_t maxParseMicros{ 0 };
+        uint64 allocations{ 0 };
+        ProtocolBenchmarkCounter tileDescription;
+        ProtocolBenchmarkCounter creatureMove;
+    };
+
+    std::string escapeJson(const std::string& str)
+    {
+        std::string out;
+        for(const char c : str) {
+            if(c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    std::string counterToJson(const ProtocolBenchmarkCounter& counter)
+    {
+        std::stringstream ss;
+        ss << "{\"calls\": " << counter.calls << ", \"ns_total\": " << counter.nanos
+            << ", \"ns_avg\": " << (counter.calls > 0 ? counter.nanos / counter.calls : 0) << "}";
+        return ss.str();
+    }
+
+    RecordResult runRecord(const std::string& file, uint32 iterations)
+    {
+        RecordResult result;
+        result.file = file;
+        result.iterations = iterations;
+
+        for(uint32 i = 0; i < iterations; ++i) {
+            const PacketPlayerPtr player(new PacketPlayer(file));
+            result.recordedMillis = player->getDuration();
+
+            ProtocolGame::tileDescriptionCounter = ProtocolBenchmarkCounter();
+            ProtocolGame::creatureMoveCounter = ProtocolBenchmarkCounter();
+
+            uint64 allocationMark = s_allocations;
+            player->setOnPacket([&](const PacketPlayer::Packet& packet, ticks_t parseMicros) {
+                result.allocations += s_allocations - allocationMark;
+                result.parseMicros += parseMicros;
+                result.maxParseMicros = std::max<ticks_t>(result.maxParseMicros, parseMicros);
+                result.bytes += packet.buffer.size();
+                ++result.packets;
+
+                // run what the main loop would run between two packets: walks, effects and text timers
+                g_clock.update();
+                g_dispatcher.poll();
+                allocationMark = s_allocations;
+            });
+
+            stdext::timer wallTimer;
+            g_game.playRecord(player, false);
+            result.wallMicros += wallTimer.elapsed_micros();
+
+            result.tileDescription.calls += ProtocolGame::tileDescriptionCounter.calls;
+            result.tileDescription.nanos += ProtocolGame::tileDescriptionCounter.nanos;
+            result.creatureMove.calls += ProtocolGame::creatureMoveCounter.calls;
+            result.creatureMove.nanos += ProtocolGame::creatureMoveCounter.nanos;
+
+            // drop the session, so every iteration starts from an empty map
+            g_game.cancelLogin();
+            g_map.clean();
+            g_clock.update();
+            g_dispatcher.poll();
+        }
+
+        return result;
+    }
+
+    std::string resultToJson(const RecordResult& result)
+    {
+        const double wallSeconds = result.wallMicros / 1000000.0;
+        std::stringstream ss;
+        ss << "    {\n";
+        ss << "      \"file\": \"" << escapeJson(result.file) << "\",\n";
+        ss << "      \"iterations\": " << result.iterations << ",\n";
+        ss << "      \"packets\": " << result.packets << ",\n";
+        ss << "      \"bytes\": " << result.bytes << ",\n";
+        ss << "      \"recorded_ms\": " << result.recordedMillis << ",\n";
+        ss << "      \"wall_ms\": " << result.wallMicros / 1000 << ",\n";
+        ss << "      \"packets_per_sec\": " << (wallSeconds > 0 ? static_cast<uint64>(result.packets / wallSeconds) : 0) << ",\n";
+        ss << "      \"parse_us\": {\"total\": " << result.parseMicros
+            << ", \"avg\": " << (result.packets > 0 ? result.parseMicros / static_cast<double>(result.packets) : 0)
+            << ", \"max\": " << result.maxParseMicros << "},\n";
+        ss << "      \"set_tile_description\": " << counterToJson(result.tileDescription) << ",\n";
+        ss << "      \"creature_move\": " << counterToJson(result.creatureMove) << ",\n";
+        ss << "      \"allocations\": {\"total\": " << result.allocations
+            << ", \"per_packet\": " << (result.packets > 0 ? result.allocations / static_cast<double>(result.packets) : 0) << "}\n";
+        ss << "    }";
+        return ss.str();
+    }
+
+    void printUsage(const std::string& program)
+    {
+        stdext::print("Usage: ", program, " [options] <record> [record...]\n"
+                      "Options:\n"
+                      "  --work-dir <dir>      Directory the other paths are relative to (default: current directory)\n"
+                      "  --dat <file>          Things file to load\n"
+                      "  --spr <file>          Sprites file to load\n"
+                      "  --otb <file>          Items file to load (optional)\n"
+                      "  --iterations <n>      Replays of each record (default: 1)\n"
+                      "  --synthetic <n>       Generate and replay a session with n walking creatures, can be repeated\n"
+                      "  --version <n>         Client version of the generated sessions (default: 1264)\n"
+                      "  --output <file>       Write the JSON report to this file instead of stdout\n");
+    }
+}
+
+void* operator new(size_t size)
+{
+    ++s_allocations;
+    if(void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    ++s_allocations;
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    ++s_allocations;
+    const size_t align = static_cast<size_t>(alignment);
+#ifdef _MSC_VER
+    if(void* ptr = _aligned_malloc(size ? size : 1, align))
+        return ptr;
+#else
+    // aligned_alloc wants a multiple of the alignment
+    if(void* ptr = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align))
+        return ptr;
+#endif
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try {
+        return operator new(size, alignment);
+    } catch(std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, alignment, tag);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+#ifdef _MSC_VER
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept
+{
+    operator delete(ptr, alignment);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(ptr, alignment);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(ptr, alignment);
+}
+
+void operator delete(void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    operator delete(ptr, alignment);
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    operator delete(ptr, alignment);
+}
+
+int main(int argc, const char* argv[])
+{
+    std::vector<std::string> args(argv, argv + argc);
+
+    std::string workDir = fs::current_path().string();
+    std::string datFile, sprFile, otbFile, outputFile;
+    uint32 iterations = 1;
+    int clientVersion = 1264;
+    std::vector<std::string> records;
+    std::vector<int> syntheticCreatures;
+
+    for(uint i = 1; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        const bool hasValue = i + 1 < args.size();
+        if(arg == "--work-dir" && hasValue)
+            workDir = args[++i];
+        else if(arg == "--dat" && hasValue)
+            datFile = args[++i];
+        else if(arg == "--spr" && hasValue)
+            sprFile = args[++i];
+        else if(arg == "--otb" && hasValue)
+            otbFile = args[++i];
+        else if(arg == "--iterations" && hasValue)
+            iterations = std::max<int>(1, stdext::unsafe_cast<int>(args[++i], 1));
+        else if(arg == "--synthetic" && hasValue)
+            syntheticCreatures.push_back(std::max<int>(0, stdext::unsafe_cast<int>(args[++i], 0)));
+        else if(arg == "--version" && hasValue)
+            clientVersion = stdext::unsafe_cast<int>(args[++i], clientVersion);
+        else if(arg == "--output" && hasValue)
+            outputFile = args[++i];
+        else if(arg == "-h" || arg == "--help" || arg.front() == '-') {
+            printUsage(args[0]);
+            return arg.front() == '-' && arg != "-h" && arg != "--help" ? 1 : 0;
+        } else
+            records.push_back(arg);
+    }
+
+    if(datFile.empty() || sprFile.empty() || (records.empty() && syntheticCreatures.empty())) {
+        printUsage(args[0]);
+        return 1;
+    }
+
+    g_app.setName("OTClient Bench");
+    g_app.setCompactName("otclient_bench");
+    g_app.setVersion("1.0.0");
+
+    // only the console part of the application is initialized, no window, GL context or sound
+    g_app.Application::init(args);
+    Client::registerLuaFunctions();
+    g_game.init();
+    g_things.init();
+    g_walks.init();
+    g_map.resetAwareRange();
+
+    if(!g_resources.addSearchPath(workDir))
+        g_logger.fatal(stdext::format("Unable to use '%s' as work directory", workDir));
+
+    // things without fonts or textures complain on every creature, keep the report clean
+    g_logger.setLevel(Fw::LogFatal);
+
+    stdext::timer loadTimer;
+    if(!g_things.loadDat(datFile))
+        g_logger.fatal(stdext::format("Unable to load dat '%s'", datFile));
+    const ticks_t datMillis = loadTimer.elapsed_millis();
+
+    loadTimer.restart();
+    if(!g_sprites.loadSpr(sprFile))
+        g_logger.fatal(stdext::format("Unable to load spr '%s'", sprFile));
+    const ticks_t sprMillis = loadTimer.elapsed_millis();
+
+    ticks_t otbMillis = 0;
+    if(!otbFile.empty()) {
+        loadTimer.restart();
+        g_things.loadOtb(otbFile);
+        otbMillis = loadTimer.elapsed_millis();
+    }
+
+    if(!syntheticCreatures.empty()) {
+        try {
+            g_resources.setWriteDir(workDir);
+            g_game.setClientVersion(clientVersion);
+            g_game.setProtocolVersion(clientVersion);
+
+            for(const int creatures : syntheticCreatures) {
+                const std::string file = stdext::format("synthetic-%d.otcr", creatures);
+                const PacketGeneratorPtr generator(new PacketGenerator);
+                generator->setCreatureCount(creatures);
+                generator->setFloorChangeInterval(5000);
+                generator->generate(file);
+                records.push_back(file);
+            }
+        } catch(stdext::exception& e) {
+            g_logger.setLevel(Fw::LogError);
+            g_logger.error(stdext::format("Unable to generate synthetic session: %s", e.what()));
+            return 1;
+        }
+    }
+
+    std::vector<RecordResult> results;
+    for(const std::string& record : records) {
+        try {
+            results.push_back(runRecord(record, iterations));
+        } catch(stdext::exception& e) {
+            g_logger.setLevel(Fw::LogError);
+            g_logger.error(stdext::format("Unable to replay '%s': %s", record, e.what()));
+            return 1;
+        }
+    }
+
+    std::stringstream ss;
+    ss << "{\n";
+    ss << "  \"build_commit\": \"" << escapeJson(BUILD_COMMIT) << "\",\n";
+    ss << "  \"build_type\": \"" << escapeJson(BUILD_TYPE) << "\",\n";
+    ss << "  \"load_ms\": {\"dat\": " << datMillis << ", \"spr\": " << sprMillis << ", \"otb\": " << otbMillis << "},\n";
+    ss << "  \"records\": [\n";
+    for(uint i = 0; i < results.size(); ++i)
+        ss << resultToJson(results[i]) << (i + 1 < results.size() ? ",\n" : "\n");
+    ss << "  ]\n";
+    ss << "}\n";
+
+    if(outputFile.empty())
+        std::cout << ss.str();
+    else
+        std::ofstream(outputFile) << ss.str();
+
+    g_dispatcher.shutdown();
+    Client::terminate();
+    g_app.Application::terminate();
+    return 0;
+}
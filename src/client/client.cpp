@@ -30,6 +30,7 @@
 #include <client/map/minimap.h>
 #include <client/manager/shadermanager.h>
 #include <client/manager/spritemanager.h>
+#include <client/manager/walkmanager.h>
 
 Client g_client;
 
@@ -43,6 +44,7 @@ void Client::init(std::vector<std::string>& /*args*/)
     g_game.init();
     g_shaders.init();
     g_things.init();
+    g_walks.init();
 
     //TODO: restore options
 /*
@@ -84,6 +86,7 @@ void Client::init(std::vector<std::string>& /*args*/)
 void Client::terminate()
 {
     g_creatures.terminate();
+    g_walks.terminate();
     g_game.terminate();
     g_map.terminate();
     g_minimap.terminate();
@@ -95,9 +95,17 @@ using SpawnMap = std::unordered_map<Position, SpawnPtr, Position::Hasher>;
 // net
 class ProtocolLogin;
 class ProtocolGame;
+class GameSession;
+class PacketGenerator;
+class PacketPlayer;
+class PacketRecorder;
 
 using ProtocolGamePtr = stdext::shared_object_ptr<ProtocolGame>;
 using ProtocolLoginPtr = stdext::shared_object_ptr<ProtocolLogin>;
+using GameSessionPtr = stdext::shared_object_ptr<GameSession>;
+using PacketGeneratorPtr = stdext::shared_object_ptr<PacketGenerator>;
+using PacketPlayerPtr = stdext::shared_object_ptr<PacketPlayer>;
+using PacketRecorderPtr = stdext::shared_object_ptr<PacketRecorder>;
 
 // ui
 class UIItem;
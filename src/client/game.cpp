@@ -31,6 +31,8 @@
 #include <client/map/map.h>
 #include <client/protocol/protocolcodes.h>
 #include <client/protocol/protocolgame.h>
+#include <client/protocol/packetplayer.h>
+#include <client/protocol/packetrecorder.h>
 #include <client/thing/text/statictext.h>
 #include <client/map/tile.h>
 
@@ -540,11 +542,48 @@ void Game::loginWorld(const std::string& account, const std::string& password, c
     m_localPlayer->setName(characterName);
 
     m_protocolGame = ProtocolGamePtr(new ProtocolGame);
+    if(!m_recordFileName.empty())
+        m_protocolGame->setRecorder(PacketRecorderPtr(new PacketRecorder(m_recordFileName)));
     m_protocolGame->login(account, password, worldHost, static_cast<uint16>(worldPort), characterName, authenticatorToken, sessionKey);
     m_characterName = characterName;
     m_worldName = worldName;
 }
 
+void Game::startRecord(const std::string& fileName)
+{
+    stopRecord();
+    m_recordFileName = fileName;
+
+    // the recording only replays from its start when it begins at login, otherwise the map is unknown
+    if(m_protocolGame)
+        m_protocolGame->setRecorder(PacketRecorderPtr(new PacketRecorder(fileName)));
+}
+
+void Game::stopRecord()
+{
+    m_recordFileName.clear();
+
+    if(m_protocolGame && m_protocolGame->getRecorder()) {
+        m_protocolGame->getRecorder()->close();
+        m_protocolGame->setRecorder(nullptr);
+    }
+}
+
+void Game::playRecord(const PacketPlayerPtr& player, bool realtime)
+{
+    if(m_protocolGame || isOnline())
+        stdext::throw_exception("Unable to play a record while already online or logging.");
+
+    // reset the new game state
+    resetGameStates();
+
+    m_localPlayer = LocalPlayerPtr(new LocalPlayer);
+    m_protocolGame = ProtocolGamePtr(new ProtocolGame);
+    m_protocolGame->playRecord(player, realtime);
+    if(!realtime)
+        player->playAll();
+}
+
 void Game::cancelLogin()
 {
     // send logout even if the game has not started yet, to make sure that the player doesn't stay logged there
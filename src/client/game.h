@@ -33,6 +33,7 @@
 #include <client/thing/creature/localplayer.h>
 #include <client/thing/creature/outfit.h>
 #include <client/protocol/protocolgame.h>
+#include <client/protocol/protocolstats.h>
 
 #include <bitset>
 
@@ -167,6 +168,12 @@ public:
     void forceLogout();
     void safeLogout();
 
+    // session recording and offline replay
+    void startRecord(const std::string& fileName);
+    void stopRecord();
+    bool isRecording() { return !m_recordFileName.empty(); }
+    void playRecord(const PacketPlayerPtr& player, bool realtime);
+
     // walk related
     bool walk(Otc::Direction_t direction);
     void autoWalk(std::vector<Otc::Direction_t> dirs);
@@ -350,6 +357,8 @@ public:
     bool isGM() { return !m_gmActions.empty(); }
     Otc::Direction_t getLastWalkDir() { return m_lastWalkDir; }
 
+    ProtocolStats& getProtocolStats() { return m_protocolStats; }
+
     std::string formatCreatureName(const std::string& name);
     int findEmptyContainerId();
 
@@ -407,6 +416,8 @@ private:
 
     int m_clientVersion;
     std::string m_clientSignature;
+    std::string m_recordFileName;
+    ProtocolStats m_protocolStats;
 };
 
 extern Game g_game;
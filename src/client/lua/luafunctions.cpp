@@ -36,6 +36,10 @@
 #include <client/thing/creature/outfit.h>
 #include <client/thing/creature/player.h>
 #include <client/protocol/protocolgame.h>
+#include <client/protocol/gamesession.h>
+#include <client/protocol/packetgenerator.h>
+#include <client/protocol/packetplayer.h>
+#include <client/protocol/packetrecorder.h>
 #include <client/manager/shadermanager.h>
 #include <client/manager/spritemanager.h>
 #include <client/thing/text/statictext.h>
@@ -57,8 +61,12 @@ void Client::registerLuaFunctions()
     g_lua.registerSingletonClass("g_things");
     g_lua.bindSingletonFunction("g_things", "loadDat", &ThingTypeManager::loadDat, &g_things);
     g_lua.bindSingletonFunction("g_things", "saveDat", &ThingTypeManager::saveDat, &g_things);
+    g_lua.bindSingletonFunction("g_things", "setDatCacheEnabled", &ThingTypeManager::setDatCacheEnabled, &g_things);
+    g_lua.bindSingletonFunction("g_things", "isDatCacheEnabled", &ThingTypeManager::isDatCacheEnabled, &g_things);
     g_lua.bindSingletonFunction("g_things", "loadOtb", &ThingTypeManager::loadOtb, &g_things);
     g_lua.bindSingletonFunction("g_things", "loadXml", &ThingTypeManager::loadXml, &g_things);
+    g_lua.bindSingletonFunction("g_things", "loadAssets", &ThingTypeManager::loadAssets, &g_things);
+    g_lua.bindSingletonFunction("g_things", "isLoadingAssets", &ThingTypeManager::isLoadingAssets, &g_things);
     g_lua.bindSingletonFunction("g_things", "loadOtml", &ThingTypeManager::loadOtml, &g_things);
     g_lua.bindSingletonFunction("g_things", "isDatLoaded", &ThingTypeManager::isDatLoaded, &g_things);
     g_lua.bindSingletonFunction("g_things", "isOtbLoaded", &ThingTypeManager::isOtbLoaded, &g_things);
@@ -127,6 +135,10 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_map", "saveOtbm", &Map::saveOtbm, &g_map);
     g_lua.bindSingletonFunction("g_map", "loadOtcm", &Map::loadOtcm, &g_map);
     g_lua.bindSingletonFunction("g_map", "saveOtcm", &Map::saveOtcm, &g_map);
+    g_lua.bindSingletonFunction("g_map", "setOtcmStreaming", &Map::setOtcmStreaming, &g_map);
+    g_lua.bindSingletonFunction("g_map", "isOtcmStreaming", &Map::isOtcmStreaming, &g_map);
+    g_lua.bindSingletonFunction("g_map", "setOtcmCacheSize", &Map::setOtcmCacheSize, &g_map);
+    g_lua.bindSingletonFunction("g_map", "getOtcmCacheSize", &Map::getOtcmCacheSize, &g_map);
     g_lua.bindSingletonFunction("g_map", "getHouseFile", &Map::getHouseFile, &g_map);
     g_lua.bindSingletonFunction("g_map", "setHouseFile", &Map::setHouseFile, &g_map);
     g_lua.bindSingletonFunction("g_map", "getSpawnFile", &Map::getSpawnFile, &g_map);
@@ -153,6 +165,9 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_map", "beginGhostMode", &Map::beginGhostMode, &g_map);
     g_lua.bindSingletonFunction("g_map", "endGhostMode", &Map::endGhostMode, &g_map);
     g_lua.bindSingletonFunction("g_map", "findItemsById", &Map::findItemsById, &g_map);
+    g_lua.bindSingletonFunction("g_map", "findItemsByIdInArea", &Map::findItemsByIdInArea, &g_map);
+    g_lua.bindSingletonFunction("g_map", "setItemIndexEnabled", &Map::setItemIndexEnabled, &g_map);
+    g_lua.bindSingletonFunction("g_map", "isItemIndexEnabled", &Map::isItemIndexEnabled, &g_map);
     g_lua.bindSingletonFunction("g_map", "setFloatingEffect", &Map::setFloatingEffect, &g_map);
     g_lua.bindSingletonFunction("g_map", "isDrawingFloatingEffects", &Map::isDrawingFloatingEffects, &g_map);
 
@@ -308,6 +323,19 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_game", "openStore", &Game::openStore, &g_game);
     g_lua.bindSingletonFunction("g_game", "transferCoins", &Game::transferCoins, &g_game);
     g_lua.bindSingletonFunction("g_game", "openTransactionHistory", &Game::openTransactionHistory, &g_game);
+    g_lua.bindSingletonFunction("g_game", "startRecord", &Game::startRecord, &g_game);
+    g_lua.bindSingletonFunction("g_game", "stopRecord", &Game::stopRecord, &g_game);
+    g_lua.bindSingletonFunction("g_game", "isRecording", &Game::isRecording, &g_game);
+    g_lua.bindSingletonFunction("g_game", "playRecord", &Game::playRecord, &g_game);
+    g_lua.bindClassStaticFunction("g_game", "getProtocolStats", [] { return g_game.getProtocolStats().getOpcodeSummaries(); });
+    g_lua.bindClassStaticFunction("g_game", "getSlowPackets", [] { return g_game.getProtocolStats().getSlowPackets(); });
+    g_lua.bindClassStaticFunction("g_game", "getProtocolPacketCount", [] { return g_game.getProtocolStats().getPacketCount(); });
+    g_lua.bindClassStaticFunction("g_game", "getProtocolByteCount", [] { return g_game.getProtocolStats().getByteCount(); });
+    g_lua.bindClassStaticFunction("g_game", "setProtocolStatsEnabled", [](bool enabled) { g_game.getProtocolStats().setEnabled(enabled); });
+    g_lua.bindClassStaticFunction("g_game", "isProtocolStatsEnabled", [] { return g_game.getProtocolStats().isEnabled(); });
+    g_lua.bindClassStaticFunction("g_game", "setSlowPacketThreshold", [](int micros) { g_game.getProtocolStats().setSlowPacketThreshold(micros); });
+    g_lua.bindClassStaticFunction("g_game", "getSlowPacketThreshold", [] { return g_game.getProtocolStats().getSlowPacketThreshold(); });
+    g_lua.bindClassStaticFunction("g_game", "resetProtocolStats", [] { g_game.getProtocolStats().reset(); });
 
     g_lua.registerSingletonClass("g_shaders");
     g_lua.bindSingletonFunction("g_shaders", "createShader", &ShaderManager::createShader, &g_shaders);
@@ -336,6 +364,74 @@ void Client::registerLuaFunctions()
     g_lua.bindClassMemberFunction<ProtocolGame>("getCreature", &ProtocolGame::getCreature);
     g_lua.bindClassMemberFunction<ProtocolGame>("getItem", &ProtocolGame::getItem);
     g_lua.bindClassMemberFunction<ProtocolGame>("getPosition", &ProtocolGame::getPosition);
+    g_lua.bindClassMemberFunction<ProtocolGame>("playRecord", &ProtocolGame::playRecord);
+    g_lua.bindClassMemberFunction<ProtocolGame>("getPlayer", &ProtocolGame::getPlayer);
+    g_lua.bindClassMemberFunction<ProtocolGame>("setRecorder", &ProtocolGame::setRecorder);
+    g_lua.bindClassMemberFunction<ProtocolGame>("getRecorder", &ProtocolGame::getRecorder);
+
+    g_lua.registerClass<GameSession, ProtocolGame>();
+    g_lua.bindClassStaticFunction<GameSession>("create", [] { return GameSessionPtr(new GameSession); });
+    g_lua.bindClassStaticFunction<GameSession>("getOnlineCount", &GameSession::getOnlineCount);
+    g_lua.bindClassMemberFunction<GameSession>("login", &GameSession::login);
+    g_lua.bindClassMemberFunction<GameSession>("logout", &GameSession::logout);
+    g_lua.bindClassMemberFunction<GameSession>("walk", &GameSession::walk);
+    g_lua.bindClassMemberFunction<GameSession>("turn", &GameSession::turn);
+    g_lua.bindClassMemberFunction<GameSession>("say", &GameSession::say);
+    g_lua.bindClassMemberFunction<GameSession>("setPingDelay", &GameSession::setPingDelay);
+    g_lua.bindClassMemberFunction<GameSession>("isOnline", &GameSession::isOnline);
+    g_lua.bindClassMemberFunction<GameSession>("getPing", &GameSession::getPing);
+    g_lua.bindClassMemberFunction<GameSession>("getPacketCount", &GameSession::getPacketCount);
+    g_lua.bindClassMemberFunction<GameSession>("getByteCount", &GameSession::getByteCount);
+    g_lua.bindClassMemberFunction<GameSession>("getPlayerId", &GameSession::getPlayerId);
+    g_lua.bindClassMemberFunction<GameSession>("getServerBeat", &GameSession::getServerBeat);
+    g_lua.bindClassMemberFunction<GameSession>("getPosition", &GameSession::getPosition);
+
+    g_lua.registerClass<PacketGenerator>();
+    g_lua.bindClassStaticFunction<PacketGenerator>("create", [] { return PacketGeneratorPtr(new PacketGenerator); });
+    g_lua.bindClassMemberFunction<PacketGenerator>("generate", &PacketGenerator::generate);
+    g_lua.bindClassMemberFunction<PacketGenerator>("setCenter", &PacketGenerator::setCenter);
+    g_lua.bindClassMemberFunction<PacketGenerator>("setCreatureCount", &PacketGenerator::setCreatureCount);
+    g_lua.bindClassMemberFunction<PacketGenerator>("setWalkInterval", &PacketGenerator::setWalkInterval);
+    g_lua.bindClassMemberFunction<PacketGenerator>("setEffectsPerSecond", &PacketGenerator::setEffectsPerSecond);
+    g_lua.bindClassMemberFunction<PacketGenerator>("setMissilesPerSecond", &PacketGenerator::setMissilesPerSecond);
+    g_lua.bindClassMemberFunction<PacketGenerator>("setAnimatedTextsPerSecond", &PacketGenerator::setAnimatedTextsPerSecond);
+    g_lua.bindClassMemberFunction<PacketGenerator>("setFloorChangeInterval", &PacketGenerator::setFloorChangeInterval);
+    g_lua.bindClassMemberFunction<PacketGenerator>("setDuration", &PacketGenerator::setDuration);
+    g_lua.bindClassMemberFunction<PacketGenerator>("setTickInterval", &PacketGenerator::setTickInterval);
+    g_lua.bindClassMemberFunction<PacketGenerator>("setGroundId", &PacketGenerator::setGroundId);
+    g_lua.bindClassMemberFunction<PacketGenerator>("setLookType", &PacketGenerator::setLookType);
+    g_lua.bindClassMemberFunction<PacketGenerator>("setEffectId", &PacketGenerator::setEffectId);
+    g_lua.bindClassMemberFunction<PacketGenerator>("setMissileId", &PacketGenerator::setMissileId);
+    g_lua.bindClassMemberFunction<PacketGenerator>("setSeed", &PacketGenerator::setSeed);
+    g_lua.bindClassMemberFunction<PacketGenerator>("getCenter", &PacketGenerator::getCenter);
+    g_lua.bindClassMemberFunction<PacketGenerator>("getCreatureCount", &PacketGenerator::getCreatureCount);
+    g_lua.bindClassMemberFunction<PacketGenerator>("getWalkInterval", &PacketGenerator::getWalkInterval);
+    g_lua.bindClassMemberFunction<PacketGenerator>("getEffectsPerSecond", &PacketGenerator::getEffectsPerSecond);
+    g_lua.bindClassMemberFunction<PacketGenerator>("getMissilesPerSecond", &PacketGenerator::getMissilesPerSecond);
+    g_lua.bindClassMemberFunction<PacketGenerator>("getAnimatedTextsPerSecond", &PacketGenerator::getAnimatedTextsPerSecond);
+    g_lua.bindClassMemberFunction<PacketGenerator>("getFloorChangeInterval", &PacketGenerator::getFloorChangeInterval);
+    g_lua.bindClassMemberFunction<PacketGenerator>("getDuration", &PacketGenerator::getDuration);
+    g_lua.bindClassMemberFunction<PacketGenerator>("getTickInterval", &PacketGenerator::getTickInterval);
+    g_lua.bindClassMemberFunction<PacketGenerator>("getPacketCount", &PacketGenerator::getPacketCount);
+
+    g_lua.registerClass<PacketPlayer>();
+    g_lua.bindClassStaticFunction<PacketPlayer>("create", [](const std::string& fileName) { return PacketPlayerPtr(new PacketPlayer(fileName)); });
+    g_lua.bindClassMemberFunction<PacketPlayer>("stop", &PacketPlayer::stop);
+    g_lua.bindClassMemberFunction<PacketPlayer>("playNext", &PacketPlayer::playNext);
+    g_lua.bindClassMemberFunction<PacketPlayer>("playAll", &PacketPlayer::playAll);
+    g_lua.bindClassMemberFunction<PacketPlayer>("getFileName", &PacketPlayer::getFileName);
+    g_lua.bindClassMemberFunction<PacketPlayer>("getPacketCount", &PacketPlayer::getPacketCount);
+    g_lua.bindClassMemberFunction<PacketPlayer>("getPlayedCount", &PacketPlayer::getPlayedCount);
+    g_lua.bindClassMemberFunction<PacketPlayer>("getDuration", &PacketPlayer::getDuration);
+    g_lua.bindClassMemberFunction<PacketPlayer>("isPlaying", &PacketPlayer::isPlaying);
+    g_lua.bindClassMemberFunction<PacketPlayer>("isFinished", &PacketPlayer::isFinished);
+
+    g_lua.registerClass<PacketRecorder>();
+    g_lua.bindClassStaticFunction<PacketRecorder>("create", [](const std::string& fileName) { return PacketRecorderPtr(new PacketRecorder(fileName)); });
+    g_lua.bindClassMemberFunction<PacketRecorder>("close", &PacketRecorder::close);
+    g_lua.bindClassMemberFunction<PacketRecorder>("getFileName", &PacketRecorder::getFileName);
+    g_lua.bindClassMemberFunction<PacketRecorder>("getPacketCount", &PacketRecorder::getPacketCount);
+    g_lua.bindClassMemberFunction<PacketRecorder>("isRecording", &PacketRecorder::isRecording);
 
     g_lua.registerClass<Container>();
     g_lua.bindClassMemberFunction<Container>("getItem", &Container::getItem);
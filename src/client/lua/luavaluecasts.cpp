@@ -225,3 +225,41 @@ bool luavalue_cast(int index, UnjustifiedPoints& unjustifiedPoints)
     }
     return false;
 }
+
+int push_luavalue(const ProtocolOpcodeSummary& summary)
+{
+    g_lua.createTable(0, 9);
+    g_lua.pushInteger(summary.opcode);
+    g_lua.setField("opcode");
+    g_lua.pushNumber(summary.count);
+    g_lua.setField("count");
+    g_lua.pushNumber(summary.bytes);
+    g_lua.setField("bytes");
+    g_lua.pushNumber(summary.totalMicros);
+    g_lua.setField("totalTime");
+    g_lua.pushNumber(summary.count > 0 ? summary.totalMicros / static_cast<double>(summary.count) : 0);
+    g_lua.setField("averageTime");
+    g_lua.pushInteger(summary.maxMicros);
+    g_lua.setField("maxTime");
+    g_lua.pushInteger(summary.p50);
+    g_lua.setField("p50");
+    g_lua.pushInteger(summary.p90);
+    g_lua.setField("p90");
+    g_lua.pushInteger(summary.p99);
+    g_lua.setField("p99");
+    return 1;
+}
+
+int push_luavalue(const SlowPacket& packet)
+{
+    g_lua.createTable(0, 4);
+    g_lua.pushNumber(packet.time);
+    g_lua.setField("time");
+    g_lua.pushNumber(packet.micros);
+    g_lua.setField("duration");
+    g_lua.pushInteger(packet.size);
+    g_lua.setField("size");
+    push_luavalue(packet.opcodes);
+    g_lua.setField("opcodes");
+    return 1;
+}
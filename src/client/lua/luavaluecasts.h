@@ -48,4 +48,8 @@ bool luavalue_cast(int index, Light& light);
 int push_luavalue(const UnjustifiedPoints& unjustifiedPoints);
 bool luavalue_cast(int index, UnjustifiedPoints& unjustifiedPoints);
 
+// protocol stats
+int push_luavalue(const ProtocolOpcodeSummary& summary);
+int push_luavalue(const SlowPacket& packet);
+
 #endif
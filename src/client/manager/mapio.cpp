@@ -25,6 +25,7 @@
 #include <client/map/tile.h>
 
 #include <framework/core/application.h>
+#include <framework/core/asyncdispatcher.h>
 #include <framework/core/binarytree.h>
 #include <framework/core/eventdispatcher.h>
 #include <framework/core/filestream.h>
@@ -32,6 +33,136 @@
 #include <framework/ui/uiwidget.h>
 #include <framework/xml/tinyxml.h>
 
+#include <zlib.h>
+
+namespace {
+    struct OtbmTile
+    {
+        Position pos;
+        uint32 flags{ TILESTATE_NONE };
+        uint32 houseId{ 0 };
+        bool houseTile{ false };
+        std::vector<ItemPtr> items;
+    };
+
+    // tile area decoded by a worker, logging is left to the main thread
+    struct OtbmTileArea
+    {
+        BinaryTreeNode node;
+        std::vector<OtbmTile> tiles;
+        std::vector<std::string> errors;
+        std::vector<std::string> warnings;
+        std::string error;
+    };
+
+    ItemPtr createOtbmItem(const uint16 id, OtbmTileArea& area)
+    {
+        // Item::createFromOtb logs invalid ids, which can't be done from a worker
+        if(!g_things.isValidOtbItemId(id)) {
+            area.errors.push_back(stdext::format("invalid thing type, server id: %d", id));
+            return ItemPtr(new Item);
+        }
+        return Item::createFromOtb(id);
+    }
+
+    void unserializeOtbmItem(const ItemPtr& item, BinaryTreeNode& node, OtbmTileArea& area)
+    {
+        try {
+            item->unserializeItem(node);
+        } catch(stdext::exception& e) {
+            area.errors.push_back(stdext::format("Failed to unserialize OTBM item: %s", e.what()));
+        }
+    }
+
+    void decodeTileArea(OtbmTileArea& area)
+    {
+        try {
+            BinaryTreeNode& nodeMapData = area.node;
+
+            Position basePos;
+            basePos.x = nodeMapData.getU16();
+            basePos.y = nodeMapData.getU16();
+            basePos.z = nodeMapData.getU8();
+
+            for(BinaryTreeNode nodeTile : nodeMapData.getChildren()) {
+                const uint8 type = nodeTile.getU8();
+                if(unlikely(type != OTBM_TILE && type != OTBM_HOUSETILE))
+                    stdext::throw_exception(stdext::format("invalid node tile type %d", static_cast<int>(type)));
+
+                area.tiles.emplace_back();
+                OtbmTile& tile = area.tiles.back();
+                tile.pos = basePos + nodeTile.getPoint();
+
+                if(type == OTBM_HOUSETILE) {
+                    tile.houseTile = true;
+                    tile.houseId = nodeTile.getU32();
+                }
+
+                while(nodeTile.canRead()) {
+                    const uint8 tileAttr = nodeTile.getU8();
+                    switch(tileAttr) {
+                    case OTBM_ATTR_TILE_FLAGS:
+                    {
+                        const uint32 _flags = nodeTile.getU32();
+                        if((_flags & TILESTATE_PROTECTIONZONE) == TILESTATE_PROTECTIONZONE)
+                            tile.flags |= TILESTATE_PROTECTIONZONE;
+                        else if((_flags & TILESTATE_OPTIONALZONE) == TILESTATE_OPTIONALZONE)
+                            tile.flags |= TILESTATE_OPTIONALZONE;
+                        else if((_flags & TILESTATE_HARDCOREZONE) == TILESTATE_HARDCOREZONE)
+                            tile.flags |= TILESTATE_HARDCOREZONE;
+
+                        if((_flags & TILESTATE_NOLOGOUT) == TILESTATE_NOLOGOUT)
+                            tile.flags |= TILESTATE_NOLOGOUT;
+
+                        if((_flags & TILESTATE_REFRESH) == TILESTATE_REFRESH)
+                            tile.flags |= TILESTATE_REFRESH;
+                        break;
+                    }
+                    case OTBM_ATTR_ITEM:
+                    {
+                        tile.items.push_back(createOtbmItem(nodeTile.getU16(), area));
+                        break;
+                    }
+                    default:
+                    {
+                        stdext::throw_exception(stdext::format("invalid tile attribute %d at pos %s",
+                                                               static_cast<int>(tileAttr), stdext::to_string(tile.pos)));
+                    }
+                    }
+                }
+
+                for(BinaryTreeNode nodeItem : nodeTile.getChildren()) {
+                    if(unlikely(nodeItem.getU8() != OTBM_ITEM))
+                        stdext::throw_exception("invalid item node");
+
+                    ItemPtr item = createOtbmItem(nodeItem.getU16(), area);
+                    unserializeOtbmItem(item, nodeItem, area);
+
+                    if(item->isContainer()) {
+                        for(BinaryTreeNode containerItem : nodeItem.getChildren()) {
+                            if(containerItem.getU8() != OTBM_ITEM)
+                                stdext::throw_exception("invalid container item node");
+
+                            ItemPtr cItem = createOtbmItem(containerItem.getU16(), area);
+                            unserializeOtbmItem(cItem, containerItem, area);
+                            item->addContainerItem(cItem);
+                        }
+                    }
+
+                    if(tile.houseTile && item->isMoveable()) {
+                        area.warnings.push_back(stdext::format("Moveable item found in house: %d at pos %s - escaping...", item->getId(), stdext::to_string(tile.pos)));
+                        continue;
+                    }
+
+                    tile.items.push_back(item);
+                }
+            }
+        } catch(std::exception& e) {
+            area.error = e.what();
+        }
+    }
+}
+
 void Map::loadOtbm(const std::string& fileName)
 {
     try {
@@ -51,37 +182,38 @@ void Map::loadOtbm(const std::string& fileName)
         if(memcmp(identifier, "OTBM", 4) != 0 && memcmp(identifier, "\0\0\0\0", 4) != 0)
             stdext::throw_exception(stdext::format("Invalid file identifier detected: %s", identifier));
 
-        BinaryTreePtr root = fin->getBinaryTree();
-        if(root->getU8())
+        BinaryTreePtr tree = fin->getBinaryTree();
+        BinaryTreeNode root = tree->getRoot();
+        if(root.getU8())
             stdext::throw_exception("could not read root property!");
 
-        const uint32 headerVersion = root->getU32();
+        const uint32 headerVersion = root.getU32();
         if(headerVersion > 3)
             stdext::throw_exception(stdext::format("Unknown OTBM version detected: %u.", headerVersion));
 
-        setWidth(root->getU16());
-        setHeight(root->getU16());
+        setWidth(root.getU16());
+        setHeight(root.getU16());
 
-        const uint32 headerMajorItems = root->getU8();
+        const uint32 headerMajorItems = root.getU8();
         if(headerMajorItems > g_things.getOtbMajorVersion()) {
             stdext::throw_exception(stdext::format("This map was saved with different OTB version. read %d what it's supposed to be: %d",
                                                    headerMajorItems, g_things.getOtbMajorVersion()));
         }
 
-        root->skip(3);
-        const uint32 headerMinorItems = root->getU32();
+        root.skip(3);
+        const uint32 headerMinorItems = root.getU32();
         if(headerMinorItems > g_things.getOtbMinorVersion()) {
             g_logger.warning(stdext::format("This map needs an updated OTB. read %d what it's supposed to be: %d or less",
                                             headerMinorItems, g_things.getOtbMinorVersion()));
         }
 
-        BinaryTreePtr node = root->getChildren()[0];
-        if(node->getU8() != OTBM_MAP_DATA)
+        BinaryTreeNode node = root.getFirstChild();
+        if(node.getU8() != OTBM_MAP_DATA)
             stdext::throw_exception("Could not read root data node");
 
-        while(node->canRead()) {
-            const uint8 attribute = node->getU8();
-            std::string tmp = node->getString();
+        while(node.canRead()) {
+            const uint8 attribute = node.getU8();
+            std::string tmp = node.getString();
             switch(attribute) {
             case OTBM_ATTR_DESCRIPTION:
                 setDescription(tmp);
@@ -97,127 +229,41 @@ void Map::loadOtbm(const std::string& fileName)
             }
         }
 
-        for(const BinaryTreePtr& nodeMapData : node->getChildren()) {
-            const uint8 mapDataType = nodeMapData->getU8();
+        // tile areas are decoded by the workers, towns and waypoints are cheap enough to read here
+        std::vector<OtbmTileArea> areas;
+        for(BinaryTreeNode nodeMapData : node.getChildren()) {
+            const uint8 mapDataType = nodeMapData.getU8();
             if(mapDataType == OTBM_TILE_AREA) {
-                Position basePos;
-                basePos.x = nodeMapData->getU16();
-                basePos.y = nodeMapData->getU16();
-                basePos.z = nodeMapData->getU8();
-
-                for(const BinaryTreePtr& nodeTile : nodeMapData->getChildren()) {
-                    const uint8 type = nodeTile->getU8();
-                    if(unlikely(type != OTBM_TILE && type != OTBM_HOUSETILE))
-                        stdext::throw_exception(stdext::format("invalid node tile type %d", static_cast<int>(type)));
-
-                    HousePtr house = nullptr;
-                    uint32 flags = TILESTATE_NONE;
-                    Position pos = basePos + nodeTile->getPoint();
-
-                    if(type == OTBM_HOUSETILE) {
-                        const uint32 hId = nodeTile->getU32();
-                        TilePtr tile = getOrCreateTile(pos);
-                        if(!(house = g_houses.getHouse(hId))) {
-                            house = HousePtr(new House(hId));
-                            g_houses.addHouse(house);
-                        }
-                        house->setTile(tile);
-                    }
-
-                    while(nodeTile->canRead()) {
-                        const uint8 tileAttr = nodeTile->getU8();
-                        switch(tileAttr) {
-                        case OTBM_ATTR_TILE_FLAGS:
-                        {
-                            const uint32 _flags = nodeTile->getU32();
-                            if((_flags & TILESTATE_PROTECTIONZONE) == TILESTATE_PROTECTIONZONE)
-                                flags |= TILESTATE_PROTECTIONZONE;
-                            else if((_flags & TILESTATE_OPTIONALZONE) == TILESTATE_OPTIONALZONE)
-                                flags |= TILESTATE_OPTIONALZONE;
-                            else if((_flags & TILESTATE_HARDCOREZONE) == TILESTATE_HARDCOREZONE)
-                                flags |= TILESTATE_HARDCOREZONE;
-
-                            if((_flags & TILESTATE_NOLOGOUT) == TILESTATE_NOLOGOUT)
-                                flags |= TILESTATE_NOLOGOUT;
-
-                            if((_flags & TILESTATE_REFRESH) == TILESTATE_REFRESH)
-                                flags |= TILESTATE_REFRESH;
-                            break;
-                        }
-                        case OTBM_ATTR_ITEM:
-                        {
-                            addThing(Item::createFromOtb(nodeTile->getU16()), pos);
-                            break;
-                        }
-                        default:
-                        {
-                            stdext::throw_exception(stdext::format("invalid tile attribute %d at pos %s",
-                                                                   static_cast<int>(tileAttr), stdext::to_string(pos)));
-                        }
-                        }
-                    }
-
-                    for(const BinaryTreePtr& nodeItem : nodeTile->getChildren()) {
-                        if(unlikely(nodeItem->getU8() != OTBM_ITEM))
-                            stdext::throw_exception("invalid item node");
-
-                        ItemPtr item = Item::createFromOtb(nodeItem->getU16());
-                        item->unserializeItem(nodeItem);
-
-                        if(item->isContainer()) {
-                            for(const BinaryTreePtr& containerItem : nodeItem->getChildren()) {
-                                if(containerItem->getU8() != OTBM_ITEM)
-                                    stdext::throw_exception("invalid container item node");
-
-                                ItemPtr cItem = Item::createFromOtb(containerItem->getU16());
-                                cItem->unserializeItem(containerItem);
-                                item->addContainerItem(cItem);
-                            }
-                        }
-
-                        if(house && item->isMoveable()) {
-                            g_logger.warning(stdext::format("Moveable item found in house: %d at pos %s - escaping...", item->getId(), stdext::to_string(pos)));
-                            item.reset();
-                        }
-
-                        addThing(item, pos);
-                    }
-
-                    if(const TilePtr& tile = getTile(pos)) {
-                        if(house)
-                            tile->setFlag(TILESTATE_HOUSE);
-                        tile->setFlag(flags);
-                    }
-                }
+                areas.push_back({ nodeMapData });
             } else if(mapDataType == OTBM_TOWNS) {
                 TownPtr town = nullptr;
-                for(const BinaryTreePtr& nodeTown : nodeMapData->getChildren()) {
-                    if(nodeTown->getU8() != OTBM_TOWN)
+                for(BinaryTreeNode nodeTown : nodeMapData.getChildren()) {
+                    if(nodeTown.getU8() != OTBM_TOWN)
                         stdext::throw_exception("invalid town node.");
 
-                    const uint32 townId = nodeTown->getU32();
-                    std::string townName = nodeTown->getString();
+                    const uint32 townId = nodeTown.getU32();
+                    std::string townName = nodeTown.getString();
 
                     Position townCoords;
-                    townCoords.x = nodeTown->getU16();
-                    townCoords.y = nodeTown->getU16();
-                    townCoords.z = nodeTown->getU8();
+                    townCoords.x = nodeTown.getU16();
+                    townCoords.y = nodeTown.getU16();
+                    townCoords.z = nodeTown.getU8();
 
                     if(!(town = g_towns.getTown(townId)))
                         g_towns.addTown(TownPtr(new Town(townId, townName, townCoords)));
                 }
                 g_towns.sort();
             } else if(mapDataType == OTBM_WAYPOINTS && headerVersion > 1) {
-                for(const BinaryTreePtr& nodeWaypoint : nodeMapData->getChildren()) {
-                    if(nodeWaypoint->getU8() != OTBM_WAYPOINT)
+                for(BinaryTreeNode nodeWaypoint : nodeMapData.getChildren()) {
+                    if(nodeWaypoint.getU8() != OTBM_WAYPOINT)
                         stdext::throw_exception("invalid waypoint node.");
 
-                    std::string name = nodeWaypoint->getString();
+                    std::string name = nodeWaypoint.getString();
 
                     Position waypointPos;
-                    waypointPos.x = nodeWaypoint->getU16();
-                    waypointPos.y = nodeWaypoint->getU16();
-                    waypointPos.z = nodeWaypoint->getU8();
+                    waypointPos.x = nodeWaypoint.getU16();
+                    waypointPos.y = nodeWaypoint.getU16();
+                    waypointPos.z = nodeWaypoint.getU8();
 
                     if(waypointPos.isValid() && !name.empty() && m_waypoints.find(waypointPos) == m_waypoints.end())
                         m_waypoints.insert(std::make_pair(waypointPos, name));
@@ -226,6 +272,45 @@ void Map::loadOtbm(const std::string& fileName)
                 stdext::throw_exception(stdext::format("Unknown map data node %d", static_cast<int>(mapDataType)));
         }
 
+        const auto group = std::make_shared<AsyncTaskGroup>();
+        for(OtbmTileArea& area : areas)
+            group->schedule([&area] { decodeTileArea(area); });
+        group->wait();
+
+        // tiles notify the map views and lua when things are added, so they are only merged here
+        for(OtbmTileArea& area : areas) {
+            for(const std::string& error : area.errors)
+                g_logger.error(error);
+            for(const std::string& warning : area.warnings)
+                g_logger.warning(warning);
+
+            for(const OtbmTile& stagedTile : area.tiles) {
+                const Position& pos = stagedTile.pos;
+
+                HousePtr house = nullptr;
+                if(stagedTile.houseTile) {
+                    const TilePtr& tile = getOrCreateTile(pos);
+                    if(!(house = g_houses.getHouse(stagedTile.houseId))) {
+                        house = HousePtr(new House(stagedTile.houseId));
+                        g_houses.addHouse(house);
+                    }
+                    house->setTile(tile);
+                }
+
+                for(const ItemPtr& item : stagedTile.items)
+                    addThing(item, pos);
+
+                if(const TilePtr& tile = getTile(pos)) {
+                    if(house)
+                        tile->setFlag(TILESTATE_HOUSE);
+                    tile->setFlag(stagedTile.flags);
+                }
+            }
+
+            if(!area.error.empty())
+                stdext::throw_exception(area.error);
+        }
+
         fin->close();
     } catch(std::exception& e) {
         g_logger.error(stdext::format("Failed to load '%s': %s", fileName, e.what()));
@@ -401,8 +486,6 @@ bool Map::loadOtcm(const std::string& fileName)
         if(!fin)
             stdext::throw_exception("unable to open file");
 
-        fin->cache();
-
         const uint32 signature = fin->getU32();
         if(signature != OTCM_SIGNATURE)
             stdext::throw_exception("invalid otcm file");
@@ -413,6 +496,7 @@ bool Map::loadOtcm(const std::string& fileName)
 
         switch(version) {
         case 1:
+        case 2:
         {
             fin->getString(); // description
             const uint32 datSignature = fin->getU32();
@@ -428,6 +512,27 @@ bool Map::loadOtcm(const std::string& fileName)
             stdext::throw_exception("otcm version not supported");
         }
 
+        if(version == 2) {
+            // only the block index table is read up front when streaming
+            if(!m_otcmStreaming)
+                fin->cache();
+            fin->seek(start);
+            openOtcmStream(fin, fileName);
+
+            if(!m_otcmStreaming) {
+                std::vector<uint8> data;
+                for(auto& it : m_otcmBlocks) {
+                    if(readOtcmBlock(it.second, false, data))
+                        insertOtcmBlock(it.second, data, false);
+                }
+                closeOtcmStream();
+            } else
+                updateOtcmStream();
+
+            return true;
+        }
+
+        fin->cache();
         fin->seek(start);
 
         while(true) {
@@ -467,6 +572,7 @@ bool Map::loadOtcm(const std::string& fileName)
 
         return true;
     } catch(stdext::exception& e) {
+        closeOtcmStream();
         g_logger.error(stdext::format("failed to load OTCM map: %s", e.what()));
         return false;
     }
@@ -474,13 +580,113 @@ bool Map::loadOtcm(const std::string& fileName)
 
 void Map::saveOtcm(const std::string& fileName)
 {
+    bool reopenStream = false;
     try {
         stdext::timer saveTimer;
 
+        struct SavedBlock
+        {
+            Position pos;
+            uint32 rawSize;
+            std::vector<uint8> data;
+        };
+
+        // every block is compressed before the file is created, it may be the streamed one
+        std::vector<SavedBlock> savedBlocks;
+        std::vector<uint8> payload;
+        std::vector<uint8> streamed;
+        std::vector<uint8> compressBuffer;
+        const int COMPRESS_LEVEL = 3;
+
+        const auto saveBlock = [&](const Position& pos) {
+            if(payload.empty())
+                return;
+
+            ulong len = compressBound(payload.size());
+            compressBuffer.resize(len);
+            const int ret = compress2(compressBuffer.data(), &len, payload.data(), payload.size(), COMPRESS_LEVEL);
+            if(ret != Z_OK)
+                stdext::throw_exception("unable to compress map block");
+
+            savedBlocks.push_back({ pos, static_cast<uint32>(payload.size()), std::vector<uint8>(compressBuffer.begin(), compressBuffer.begin() + len) });
+        };
+
+        std::unordered_set<uint64> savedKeys;
+        for(uint8_t z = 0; z <= MAX_Z; ++z) {
+            for(const auto& it : m_tileBlocks[z]) {
+                const TileBlock& block = it.second;
+
+                std::array<bool, BLOCK_SIZE * BLOCK_SIZE> hasTile = {};
+                Position blockPos;
+                payload.clear();
+                for(const TilePtr& tile : block.getTiles()) {
+                    if(!tile || tile->isEmpty())
+                        continue;
+
+                    const Position& pos = tile->getPosition();
+                    const uint16 tileIndex = (pos.y % BLOCK_SIZE) * BLOCK_SIZE + (pos.x % BLOCK_SIZE);
+                    blockPos = Position(pos.x - pos.x % BLOCK_SIZE, pos.y - pos.y % BLOCK_SIZE, pos.z);
+                    hasTile[tileIndex] = true;
+
+                    uint8 count = 0;
+                    payload.resize(payload.size() + 3);
+                    const size_t countPos = payload.size() - 1;
+                    stdext::writeULE16(&payload[countPos - 2], tileIndex);
+
+                    for(const ThingPtr& thing : tile->getThings()) {
+                        if(!thing->isItem() || count == 255)
+                            continue;
+
+                        const ItemPtr item = thing->static_self_cast<Item>();
+                        payload.resize(payload.size() + 3);
+                        stdext::writeULE16(&payload[payload.size() - 3], item->getId());
+                        payload.back() = item->getCountOrSubType();
+                        ++count;
+                    }
+                    payload[countPos] = count;
+                }
+
+                if(payload.empty())
+                    continue;
+
+                // tiles of the streamed file that were not loaded are kept
+                const uint64 key = getOtcmBlockKey(blockPos);
+                const auto streamIt = m_otcmBlocks.find(key);
+                if(streamIt != m_otcmBlocks.end() && readOtcmBlock(streamIt->second, false, streamed)) {
+                    size_t pos = 0;
+                    while(pos + 3 <= streamed.size()) {
+                        const uint16 tileIndex = stdext::readULE16(&streamed[pos]);
+                        const size_t tileSize = 3 + streamed[pos + 2] * 3;
+                        if(pos + tileSize > streamed.size())
+                            break;
+
+                        if(tileIndex < hasTile.size() && !hasTile[tileIndex])
+                            payload.insert(payload.end(), streamed.begin() + pos, streamed.begin() + pos + tileSize);
+                        pos += tileSize;
+                    }
+                }
+
+                savedKeys.insert(key);
+                saveBlock(blockPos);
+            }
+        }
+
+        // streamed blocks that are not in memory are copied as they are
+        for(auto& it : m_otcmBlocks) {
+            OtcmBlock& block = it.second;
+            if(savedKeys.find(it.first) != savedKeys.end() || !readOtcmBlock(block, true, streamed))
+                continue;
+
+            savedBlocks.push_back({ block.pos, block.rawSize, streamed });
+        }
+
+        reopenStream = m_otcmFile && m_otcmFileName == fileName;
+        if(reopenStream)
+            m_otcmFile->close();
+
         FileStreamPtr fin = g_resources.createFile(fileName);
         fin->cache();
 
-        //TODO: compression flag with zlib
         const uint32 flags = 0;
 
         // header
@@ -489,8 +695,8 @@ void Map::saveOtcm(const std::string& fileName)
         fin->addU16(OTCM_VERSION);
         fin->addU32(flags);
 
-        // version 1 header
-        fin->addString("OTCM 1.0"); // map description
+        // version 2 header
+        fin->addString("OTCM 2.0"); // map description
         fin->addU32(g_things.getDatSignature());
         fin->addU16(g_game.getClientVersion());
         fin->addString(g_game.getWorldName());
@@ -501,44 +707,277 @@ void Map::saveOtcm(const std::string& fileName)
         fin->addU16(start);
         fin->seek(start);
 
-        for(uint8_t z = 0; z <= MAX_Z; ++z) {
-            for(const auto& it : m_tileBlocks[z]) {
-                const TileBlock& block = it.second;
-                for(const TilePtr& tile : block.getTiles()) {
-                    if(!tile || tile->isEmpty())
-                        continue;
+        // block index table, each block is compressed on its own so it can be loaded alone
+        fin->addU32(savedBlocks.size());
+        uint32 offset = start + 4 + savedBlocks.size() * 17;
+        for(const SavedBlock& block : savedBlocks) {
+            fin->addU16(block.pos.x);
+            fin->addU16(block.pos.y);
+            fin->addU8(block.pos.z);
+            fin->addU32(offset);
+            fin->addU32(block.data.size());
+            fin->addU32(block.rawSize);
+            offset += block.data.size();
+        }
 
-                    const Position pos = tile->getPosition();
-                    fin->addU16(pos.x);
-                    fin->addU16(pos.y);
-                    fin->addU8(pos.z);
+        for(const SavedBlock& block : savedBlocks)
+            fin->write(block.data.data(), block.data.size());
 
-                    for(const ThingPtr& thing : tile->getThings()) {
-                        if(thing->isItem()) {
-                            ItemPtr item = thing->static_self_cast<Item>();
-                            fin->addU16(item->getId());
-                            fin->addU8(item->getCountOrSubType());
-                        }
-                    }
+        fin->flush();
+        fin->close();
+
+        if(reopenStream) {
+            FileStreamPtr streamFile = g_resources.openFile(fileName);
+            streamFile->seek(start);
+            openOtcmStream(streamFile, fileName);
+            reopenStream = false;
+        }
+    } catch(stdext::exception& e) {
+        // the streamed file was already closed to be rewritten
+        if(reopenStream)
+            closeOtcmStream();
+        g_logger.error(stdext::format("failed to save OTCM map: %s", e.what()));
+    }
+}
+
+void Map::openOtcmStream(const FileStreamPtr& fin, const std::string& fileName)
+{
+    // blocks already in memory stay tracked by the lru when the same map is reopened,
+    // along with the tiles they created so they can still be evicted
+    struct CachedBlock
+    {
+        uint64 key;
+        std::bitset<BLOCK_SIZE * BLOCK_SIZE> tiles;
+        bool resident;
+    };
+    std::vector<CachedBlock> lru;
+    if(m_otcmFileName == fileName) {
+        for(const uint64 key : m_otcmLru) {
+            const OtcmBlock& block = m_otcmBlocks[key];
+            lru.push_back({ key, block.tiles, block.resident });
+        }
+    }
+    closeOtcmStream();
+
+    const uint32 blockCount = fin->getU32();
+    m_otcmBlocks.reserve(blockCount);
+    for(uint32 i = 0; i < blockCount; ++i) {
+        OtcmBlock block;
+        block.pos.x = fin->getU16();
+        block.pos.y = fin->getU16();
+        block.pos.z = fin->getU8();
+        block.offset = fin->getU32();
+        block.size = fin->getU32();
+        block.rawSize = fin->getU32();
+        if(!block.pos.isMapPosition())
+            stdext::throw_exception("invalid otcm block position");
+
+        m_otcmBlocks.emplace(getOtcmBlockKey(block.pos), std::move(block));
+    }
+
+    for(const CachedBlock& entry : lru) {
+        const auto it = m_otcmBlocks.find(entry.key);
+        if(it == m_otcmBlocks.end())
+            continue;
+
+        OtcmBlock& block = it->second;
+        m_otcmLru.push_back(entry.key);
+        block.lruIt = std::prev(m_otcmLru.end());
+        block.cached = true;
+        block.tiles = entry.tiles;
+        block.resident = entry.resident;
+    }
+
+    m_otcmFile = fin;
+    m_otcmFileName = fileName;
+}
+
+void Map::closeOtcmStream()
+{
+    if(m_otcmFile) {
+        m_otcmFile->close();
+        m_otcmFile = nullptr;
+    }
+
+    m_otcmFileName.clear();
+    m_otcmBlocks.clear();
+    m_otcmLru.clear();
+}
+
+void Map::updateOtcmStream()
+{
+    if(!m_otcmFile || !m_centralPosition.isValid())
+        return;
+
+    const bool keepUnawareTiles = g_game.getFeature(Otc::GameKeepUnawareTiles);
+    if(!keepUnawareTiles) {
+        // blocks crossing the aware range border may have lost their unaware tiles, they are
+        // revisited and only the missing tiles that are aware again get recreated
+        for(const uint64 key : m_otcmLru) {
+            OtcmBlock& block = m_otcmBlocks[key];
+            if(block.resident && !(isAwareOfPosition(block.pos) && isAwareOfPosition(Position(block.pos.x + BLOCK_SIZE - 1, block.pos.y + BLOCK_SIZE - 1, block.pos.z))))
+                block.resident = false;
+        }
+    }
 
-                    // end of tile
-                    fin->addU16(0xFFFF);
+    // unaware tiles are only kept with the feature, so only then blocks are loaded ahead
+    const int margin = keepUnawareTiles ? BLOCK_SIZE : 0;
+
+    size_t touched = 0;
+    std::vector<uint8> data;
+    for(int z = getFirstAwareFloor(); z <= getLastAwareFloor(); ++z) {
+        const int offset = std::abs(m_centralPosition.z - z) + margin;
+        const int left = std::max<int>(m_centralPosition.x - m_awareRange.left - offset, 0) / BLOCK_SIZE;
+        const int right = std::min<int>(m_centralPosition.x + m_awareRange.right + offset, 65535) / BLOCK_SIZE;
+        const int top = std::max<int>(m_centralPosition.y - m_awareRange.top - offset, 0) / BLOCK_SIZE;
+        const int bottom = std::min<int>(m_centralPosition.y + m_awareRange.bottom + offset, 65535) / BLOCK_SIZE;
+
+        for(int y = top; y <= bottom; ++y) {
+            for(int x = left; x <= right; ++x) {
+                const uint64 key = getOtcmBlockKey(Position(x * BLOCK_SIZE, y * BLOCK_SIZE, z));
+                const auto it = m_otcmBlocks.find(key);
+                if(it == m_otcmBlocks.end())
+                    continue;
+
+                OtcmBlock& block = it->second;
+                if(block.cached)
+                    m_otcmLru.splice(m_otcmLru.begin(), m_otcmLru, block.lruIt);
+                else {
+                    m_otcmLru.push_front(key);
+                    block.lruIt = m_otcmLru.begin();
+                    block.cached = true;
                 }
+                ++touched;
+
+                if(block.resident)
+                    continue;
+
+                if(block.data.empty() && !readOtcmBlock(block, false, block.data))
+                    continue;
+
+                block.resident = insertOtcmBlock(block, block.data, !keepUnawareTiles);
             }
         }
+    }
 
-        // end of file
-        const Position invalidPos;
-        fin->addU16(invalidPos.x);
-        fin->addU16(invalidPos.y);
-        fin->addU8(invalidPos.z);
+    // least recently seen blocks are dropped, the ones around the camera always stay
+    while(m_otcmLru.size() > std::max<size_t>(m_otcmCacheSize, touched)) {
+        evictOtcmBlock(m_otcmBlocks[m_otcmLru.back()]);
+        m_otcmLru.pop_back();
+    }
+}
 
-        fin->flush();
+bool Map::readOtcmBlock(OtcmBlock& block, bool compressed, std::vector<uint8>& data)
+{
+    if(!compressed && !block.data.empty()) {
+        if(&data != &block.data)
+            data = block.data;
+        return true;
+    }
 
-        fin->close();
+    try {
+        std::vector<uint8> buffer(block.size);
+        m_otcmFile->seek(block.offset);
+        if(m_otcmFile->read(buffer.data(), block.size) != static_cast<int>(block.size))
+            stdext::throw_exception("unexpected end of file");
+
+        if(compressed) {
+            data = std::move(buffer);
+            return true;
+        }
+
+        ulong len = block.rawSize;
+        data.resize(block.rawSize);
+        if(uncompress(data.data(), &len, buffer.data(), buffer.size()) != Z_OK || len != block.rawSize)
+            stdext::throw_exception("corrupted block data");
+
+        return true;
     } catch(stdext::exception& e) {
-        g_logger.error(stdext::format("failed to save OTCM map: %s", e.what()));
+        g_logger.error(stdext::format("failed to read OTCM block at %s: %s", stdext::to_string(block.pos), e.what()));
+        data.clear();
+        return false;
     }
 }
 
+bool Map::insertOtcmBlock(OtcmBlock& block, const std::vector<uint8>& data, bool awareOnly)
+{
+    bool complete = true;
+    size_t pos = 0;
+    while(pos + 3 <= data.size()) {
+        const uint16 tileIndex = stdext::readULE16(&data[pos]);
+        const uint8 count = data[pos + 2];
+        pos += 3;
+        if(pos + count * 3 > data.size() || tileIndex >= BLOCK_SIZE * BLOCK_SIZE)
+            break;
+
+        const Position tilePos(block.pos.x + tileIndex % BLOCK_SIZE, block.pos.y + tileIndex / BLOCK_SIZE, block.pos.z);
+
+        // unaware tiles would be dropped again by the next removeUnawareThings
+        if(awareOnly && !isAwareOfPosition(tilePos)) {
+            complete = false;
+            pos += count * 3;
+            continue;
+        }
+
+        // tiles already known, usually sent by the server, are newer than the saved ones
+        if(const TilePtr& tile = getTile(tilePos)) {
+            if(!tile->isEmpty()) {
+                pos += count * 3;
+                continue;
+            }
+        }
+
+        const TilePtr& tile = createTile(tilePos);
+        int stackPos = 0;
+        for(int i = 0; i < count; ++i, pos += 3) {
+            ItemPtr item = Item::create(stdext::readULE16(&data[pos]));
+            item->setCountOrSubType(data[pos + 2]);
+
+            if(item->isValid())
+                tile->addThing(item, ++stackPos);
+        }
+        block.tiles.set(tileIndex);
+
+        notificateTileUpdate(tilePos);
+    }
+    return complete;
+}
+
+void Map::releaseOtcmTile(const Position& pos)
+{
+    const auto it = m_otcmBlocks.find(getOtcmBlockKey(pos));
+    if(it != m_otcmBlocks.end())
+        it->second.tiles.reset((pos.y % BLOCK_SIZE) * BLOCK_SIZE + pos.x % BLOCK_SIZE);
+}
+
+void Map::evictOtcmBlock(OtcmBlock& block)
+{
+    // only the tiles that came from the file go, the ones the server took over stay
+    if(block.tiles.any()) {
+        const auto it = m_tileBlocks[block.pos.z].find(getBlockIndex(block.pos));
+        if(it != m_tileBlocks[block.pos.z].end()) {
+            TileBlock& tileBlock = it->second;
+            for(uint tileIndex = 0; tileIndex < block.tiles.size(); ++tileIndex) {
+                if(!block.tiles.test(tileIndex))
+                    continue;
+
+                const Position tilePos(block.pos.x + tileIndex % BLOCK_SIZE, block.pos.y + tileIndex / BLOCK_SIZE, block.pos.z);
+                const TilePtr& tile = tileBlock.get(tilePos);
+                if(tile && !tile->hasCreature())
+                    tileBlock.remove(tilePos);
+            }
+
+            const auto& tiles = tileBlock.getTiles();
+            if(std::none_of(tiles.begin(), tiles.end(), [](const TilePtr& tile) { return !!tile; }))
+                m_tileBlocks[block.pos.z].erase(it);
+        }
+    }
+
+    block.data.clear();
+    block.data.shrink_to_fit();
+    block.tiles.reset();
+    block.cached = false;
+    block.resident = false;
+}
+
 /* vim: set ts=4 sw=4 et: */
@@ -45,17 +45,7 @@ bool SpriteManager::loadSpr(std::string file)
     m_signature = 0;
     m_loaded = false;
     try {
-        file = g_resources.guessFilePath(file, "spr");
-
-        m_spritesFile = g_resources.openFile(file);
-        // cache file buffer to avoid lags from hard drive
-        m_spritesFile->cache();
-
-        m_signature = m_spritesFile->getU32();
-        m_spritesCount = m_spritesFile->getU32();
-        m_spritesOffset = m_spritesFile->tell();
-        m_loaded = true;
-        g_lua.callGlobalField("g_sprites", "onLoadSpr", file);
+        setSpr(openSpr(file));
         return true;
     } catch(stdext::exception& e) {
         g_logger.error(stdext::format("Failed to load sprites from '%s': %s", file, e.what()));
@@ -63,6 +53,31 @@ bool SpriteManager::loadSpr(std::string file)
     }
 }
 
+SpriteManager::SprFile SpriteManager::openSpr(std::string file)
+{
+    SprFile spr;
+    spr.fileName = g_resources.guessFilePath(file, "spr");
+
+    spr.file = g_resources.openFile(spr.fileName);
+    // cache file buffer to avoid lags from hard drive
+    spr.file->cache();
+
+    spr.signature = spr.file->getU32();
+    spr.spritesCount = spr.file->getU32();
+    spr.spritesOffset = spr.file->tell();
+    return spr;
+}
+
+void SpriteManager::setSpr(const SprFile& spr)
+{
+    m_spritesFile = spr.file;
+    m_signature = spr.signature;
+    m_spritesCount = spr.spritesCount;
+    m_spritesOffset = spr.spritesOffset;
+    m_loaded = true;
+    g_lua.callGlobalField("g_sprites", "onLoadSpr", spr.fileName);
+}
+
 void SpriteManager::saveSpr(const std::string& fileName)
 {
     if(!m_loaded)
@@ -116,6 +131,7 @@ void SpriteManager::saveSpr(const std::string& fileName)
 
 void SpriteManager::unload()
 {
+    m_loaded = false;
     m_spritesCount = 0;
     m_signature = 0;
     m_spritesFile = nullptr;
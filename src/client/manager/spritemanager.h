@@ -35,11 +35,22 @@ class SpriteManager
     };
 
 public:
+    /// Sprite file opened by openSpr, it's safe to do it in a worker thread and publish it with setSpr later
+    struct SprFile {
+        std::string fileName;
+        FileStreamPtr file;
+        uint32 signature{ 0 };
+        int spritesCount{ 0 };
+        int spritesOffset{ 0 };
+    };
+
 		SpriteManager();
 
     void terminate();
 
     bool loadSpr(std::string file);
+    static SprFile openSpr(std::string file);
+    void setSpr(const SprFile& spr);
     void unload();
 
     void saveSpr(const std::string& fileName);
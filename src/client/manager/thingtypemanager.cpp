@@ -28,7 +28,9 @@
 #include <client/manager/spritemanager.h>
 #include <client/thing/thing.h>
 #include <client/thing/type/thingtype.h>
+#include <client/thing/type/thingtypecache.h>
 
+#include <framework/core/asyncdispatcher.h>
 #include <framework/core/binarytree.h>
 #include <framework/core/filestream.h>
 #include <framework/core/resourcemanager.h>
@@ -37,6 +39,21 @@
 
 ThingTypeManager g_things;
 
+struct ThingTypeManager::AssetsLoad {
+    std::atomic<bool> canceled{ false };
+    std::atomic<int> otbXmlPending{ 0 };
+    int total{ 0 };
+    int done{ 0 };
+
+    std::string datFile, sprFile, otbFile, xmlFile;
+    std::string datError, sprError, otbError, xmlError;
+
+    DatAssets dat;
+    SpriteManager::SprFile spr;
+    OtbAssets otb;
+    std::shared_ptr<TiXmlDocument> xml;
+};
+
 void ThingTypeManager::init()
 {
     m_nullThingType = ThingTypePtr(new ThingType);
@@ -56,6 +73,11 @@ void ThingTypeManager::init()
 
 void ThingTypeManager::terminate()
 {
+    if(m_assetsLoad) {
+        m_assetsLoad->canceled = true;
+        m_assetsLoad = nullptr;
+    }
+
     for(auto& m_thingType : m_thingTypes)
         m_thingType.clear();
     m_itemTypes.clear();
@@ -103,39 +125,251 @@ bool ThingTypeManager::loadDat(std::string file)
     m_datSignature = 0;
     m_contentRevision = 0;
     try {
-        file = g_resources.guessFilePath(file, "dat");
+        DatAssets dat;
+        dat.clientVersion = g_game.getClientVersion();
+        unserializeDat(file, dat);
+        setDat(dat);
+        return true;
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("Failed to read dat '%s': %s'", file, e.what()));
+        return false;
+    }
+}
+
+void ThingTypeManager::unserializeDat(const std::string& file, DatAssets& dat)
+{
+    dat.file = g_resources.guessFilePath(file, "dat");
+
+    FileStreamPtr fin = g_resources.openFile(dat.file);
+
+    dat.signature = fin->getU32();
 
-        FileStreamPtr fin = g_resources.openFile(file);
+    ThingTypeCache::Key cacheKey;
+    cacheKey.datSignature = dat.signature;
+    cacheKey.datSize = fin->size();
+    cacheKey.datTime = g_resources.getFileTime(dat.file);
+    cacheKey.clientVersion = dat.clientVersion;
 
-        m_datSignature = fin->getU32();
-        m_contentRevision = static_cast<uint16_t>(m_datSignature);
+    const std::string cacheFile = getDatCacheFile(dat.file, dat.clientVersion);
+    if(m_datCacheEnabled && loadDatCache(cacheFile, cacheKey, dat))
+        return;
 
-        for(auto& m_thingType : m_thingTypes) {
-            const int count = fin->getU16() + 1;
-            m_thingType.clear();
-            m_thingType.resize(count, m_nullThingType);
+    dat.saveCache = m_datCacheEnabled;
+    dat.cacheFile = cacheFile;
+    dat.cacheKey = cacheKey;
+
+    fin->cache();
+
+    // null entries are replaced by the null thing type once published
+    for(auto& thingTypes : dat.thingTypes) {
+        const int count = fin->getU16() + 1;
+        thingTypes.resize(count);
+    }
+
+    for(int category = 0; category < ThingLastCategory; ++category) {
+        uint16 firstId = 1;
+        if(category == ThingCategoryItem)
+            firstId = 100;
+        for(uint16 id = firstId; id < dat.thingTypes[category].size(); ++id) {
+            ThingTypePtr type(new ThingType);
+            type->unserialize(id, static_cast<ThingCategory>(category), fin);
+            dat.thingTypes[category][id] = type;
         }
+    }
 
-        for(int category = 0; category < ThingLastCategory; ++category) {
-            uint16 firstId = 1;
-            if(category == ThingCategoryItem)
-                firstId = 100;
-            for(uint16 id = firstId; id < m_thingTypes[category].size(); ++id) {
-                ThingTypePtr type(new ThingType);
-                type->unserialize(id, static_cast<ThingCategory>(category), fin);
-                m_thingTypes[category][id] = type;
-            }
+}
+
+void ThingTypeManager::setDat(DatAssets& dat)
+{
+    for(const std::string& warning : dat.warnings)
+        g_logger.warning(warning);
+
+    if(dat.saveCache)
+        ThingTypeCache().save(dat.cacheFile, dat.cacheKey, dat.thingTypes);
+
+    for(int category = 0; category < ThingLastCategory; ++category) {
+        for(auto& type : dat.thingTypes[category]) {
+            if(!type)
+                type = m_nullThingType;
         }
+        m_thingTypes[category].swap(dat.thingTypes[category]);
+    }
+
+    m_datSignature = dat.signature;
+    m_contentRevision = static_cast<uint16_t>(m_datSignature);
+    m_datLoaded = true;
+    g_lua.callGlobalField("g_things", "onLoadDat", dat.file);
+}
 
-        m_datLoaded = true;
-        g_lua.callGlobalField("g_things", "onLoadDat", file);
+bool ThingTypeManager::loadDatCache(const std::string& file, const ThingTypeCache::Key& key, DatAssets& dat)
+{
+    try {
+        ThingTypeCache cache;
+        if(!cache.load(file, key))
+            return false;
+        cache.restore(dat.thingTypes, nullptr);
         return true;
     } catch(stdext::exception& e) {
-        g_logger.error(stdext::format("Failed to read dat '%s': %s'", file, e.what()));
+        dat.warnings.push_back(stdext::format("Discarding dat cache '%s': %s", file, e.what()));
         return false;
     }
 }
 
+std::string ThingTypeManager::getDatCacheFile(const std::string& file, int clientVersion)
+{
+    std::string name = file;
+    const auto slash = name.find_last_of('/');
+    if(slash != std::string::npos)
+        name = name.substr(slash + 1);
+    const auto dot = name.find_last_of('.');
+    if(dot != std::string::npos)
+        name = name.substr(0, dot);
+    return stdext::format("/cache/%s-%d.datc", name, clientVersion);
+}
+
+void ThingTypeManager::loadAssets(const std::string& datFile, const std::string& sprFile, const std::string& otbFile, const std::string& xmlFile)
+{
+    // a newer load supersedes the one in progress, its results are dropped
+    if(m_assetsLoad)
+        m_assetsLoad->canceled = true;
+
+    const auto load = std::make_shared<AssetsLoad>();
+    m_assetsLoad = load;
+    // relative paths depend on the running script, so they can't be resolved from the workers
+    const auto resolve = [](const std::string& file) { return file.empty() ? file : g_resources.resolvePath(file); };
+    load->datFile = resolve(datFile);
+    load->sprFile = resolve(sprFile);
+    load->otbFile = resolve(otbFile);
+    load->xmlFile = resolve(xmlFile);
+    load->total = !datFile.empty() + !sprFile.empty() + !otbFile.empty() + !xmlFile.empty();
+    if(load->total == 0) {
+        publishAssets(load);
+        return;
+    }
+
+    if(!datFile.empty()) {
+        load->dat.clientVersion = g_game.getClientVersion();
+        g_asyncDispatcher.dispatch([this, load] {
+            try {
+                unserializeDat(load->datFile, load->dat);
+            } catch(std::exception& e) {
+                load->datError = e.what();
+            }
+            finishAssetsStep(load, load->datFile);
+        });
+    }
+
+    if(!sprFile.empty()) {
+        g_asyncDispatcher.dispatch([this, load] {
+            try {
+                load->spr = SpriteManager::openSpr(load->sprFile);
+            } catch(std::exception& e) {
+                load->sprError = e.what();
+            }
+            finishAssetsStep(load, load->sprFile);
+        });
+    }
+
+    // the xml document is parsed while the otb is decoded, then applied to the decoded item types
+    load->otbXmlPending = !otbFile.empty() + !xmlFile.empty();
+    const auto applyXml = [this, load] {
+        if(--load->otbXmlPending > 0 || load->xmlFile.empty())
+            return;
+
+        if(load->otbFile.empty() || !load->otbError.empty())
+            load->xmlError = "OTB must be loaded before XML";
+        else if(load->xmlError.empty()) {
+            try {
+                unserializeXml(*load->xml, load->otb.itemTypes);
+            } catch(std::exception& e) {
+                load->xmlError = e.what();
+            }
+        }
+        load->xml = nullptr;
+        finishAssetsStep(load, load->xmlFile);
+    };
+
+    if(!otbFile.empty()) {
+        g_asyncDispatcher.dispatch([this, load, applyXml] {
+            try {
+                unserializeOtb(load->otbFile, load->otb);
+            } catch(std::exception& e) {
+                load->otbError = e.what();
+            }
+            finishAssetsStep(load, load->otbFile);
+            applyXml();
+        });
+    }
+
+    if(!xmlFile.empty()) {
+        g_asyncDispatcher.dispatch([this, load, applyXml] {
+            try {
+                load->xml = parseXml(load->xmlFile);
+            } catch(std::exception& e) {
+                load->xmlError = e.what();
+            }
+            applyXml();
+        });
+    }
+}
+
+void ThingTypeManager::finishAssetsStep(const AssetsLoadPtr& load, const std::string& file)
+{
+    g_asyncDispatcher.dispatchToMain([this, load, file] {
+        if(load->canceled)
+            return;
+
+        ++load->done;
+        g_lua.callGlobalField("g_things", "onAssetsLoadProgress", load->done, load->total, file);
+        if(load->done == load->total)
+            publishAssets(load);
+    });
+}
+
+void ThingTypeManager::publishAssets(const AssetsLoadPtr& load)
+{
+    m_assetsLoad = nullptr;
+
+    if(!load->datFile.empty()) {
+        if(load->datError.empty())
+            setDat(load->dat);
+        else {
+            m_datLoaded = false;
+            m_datSignature = 0;
+            m_contentRevision = 0;
+            for(const std::string& warning : load->dat.warnings)
+                g_logger.warning(warning);
+            g_logger.error(stdext::format("Failed to read dat '%s': %s'", load->datFile, load->datError));
+        }
+    }
+
+    if(!load->sprFile.empty()) {
+        if(load->sprError.empty())
+            g_sprites.setSpr(load->spr);
+        else {
+            g_sprites.unload();
+            g_logger.error(stdext::format("Failed to load sprites from '%s': %s", load->sprFile, load->sprError));
+        }
+    }
+
+    if(!load->otbFile.empty()) {
+        if(load->otbError.empty())
+            setOtb(load->otb);
+        else
+            g_logger.error(stdext::format("Failed to load '%s' (OTB file): %s", load->otbFile, load->otbError));
+    }
+
+    if(!load->xmlFile.empty()) {
+        if(load->xmlError.empty()) {
+            m_xmlLoaded = true;
+            g_logger.debug("items.xml read successfully.");
+        } else
+            g_logger.error(stdext::format("Failed to load '%s' (XML file): %s", load->xmlFile, load->xmlError));
+    }
+
+    g_lua.callGlobalField("g_things", "onAssetsLoaded");
+}
+
 bool ThingTypeManager::loadOtml(std::string file)
 {
     try {
@@ -174,98 +408,100 @@ bool ThingTypeManager::loadOtml(std::string file)
 void ThingTypeManager::loadOtb(const std::string& file)
 {
     try {
-        FileStreamPtr fin = g_resources.openFile(file);
+        OtbAssets otb;
+        unserializeOtb(file, otb);
+        setOtb(otb);
+    } catch(std::exception& e) {
+        g_logger.error(stdext::format("Failed to load '%s' (OTB file): %s", file, e.what()));
+    }
+}
 
-        uint signature = fin->getU32();
-        if(signature != 0)
-            stdext::throw_exception("invalid otb file");
+void ThingTypeManager::unserializeOtb(const std::string& file, OtbAssets& otb)
+{
+    otb.file = file;
 
-        BinaryTreePtr root = fin->getBinaryTree();
-        root->skip(1); // otb first byte is always 0
+    FileStreamPtr fin = g_resources.openFile(file);
 
-        signature = root->getU32();
-        if(signature != 0)
-            stdext::throw_exception("invalid otb file");
+    uint signature = fin->getU32();
+    if(signature != 0)
+        stdext::throw_exception("invalid otb file");
 
-        const uint8 rootAttr = root->getU8();
-        if(rootAttr == 0x01) { // OTB_ROOT_ATTR_VERSION
-            const uint16 size = root->getU16();
-            if(size != 4 + 4 + 4 + 128)
-                stdext::throw_exception("invalid otb root attr version size");
+    BinaryTreePtr tree = fin->getBinaryTree();
+    BinaryTreeNode root = tree->getRoot();
+    root.skip(1); // otb first byte is always 0
 
-            m_otbMajorVersion = root->getU32();
-            m_otbMinorVersion = root->getU32();
-            root->skip(4); // buildNumber
-            root->skip(128); // description
-        }
+    signature = root.getU32();
+    if(signature != 0)
+        stdext::throw_exception("invalid otb file");
 
-        BinaryTreeVec children = root->getChildren();
-        m_reverseItemTypes.clear();
-        m_itemTypes.resize(children.size() + 1, m_nullItemType);
-        m_reverseItemTypes.resize(children.size() + 1, m_nullItemType);
+    const uint8 rootAttr = root.getU8();
+    if(rootAttr == 0x01) { // OTB_ROOT_ATTR_VERSION
+        const uint16 size = root.getU16();
+        if(size != 4 + 4 + 4 + 128)
+            stdext::throw_exception("invalid otb root attr version size");
 
-        for(const BinaryTreePtr& node : children) {
-            ItemTypePtr itemType(new ItemType);
-            itemType->unserialize(node);
-            addItemType(itemType);
+        otb.majorVersion = root.getU32();
+        otb.minorVersion = root.getU32();
+        root.skip(4); // buildNumber
+        root.skip(128); // description
+    }
 
-            const uint16 clientId = itemType->getClientId();
-            if(unlikely(clientId >= m_reverseItemTypes.size()))
-                m_reverseItemTypes.resize(clientId + 1);
-            m_reverseItemTypes[clientId] = itemType;
+    // null entries are replaced by the null item type once published
+    const uint childrenCount = root.getChildrenCount();
+    otb.itemTypes.resize(childrenCount + 1);
+    otb.reverseItemTypes.resize(childrenCount + 1);
+
+    uint16 lastId = 99;
+    for(BinaryTreeNode node : root.getChildren()) {
+        ItemTypePtr itemType(new ItemType);
+        itemType->unserialize(node);
+
+        // fill the server ids skipped by the otb with blank item types
+        const uint16 serverId = itemType->getServerId();
+        if(serverId > 99 && lastId > 99) {
+            while(lastId + 1 < serverId) {
+                ItemTypePtr blankType(new ItemType);
+                blankType->setServerId(++lastId);
+                addItemType(blankType, otb.itemTypes);
+            }
         }
+        lastId = serverId;
 
-        m_otbLoaded = true;
-        g_lua.callGlobalField("g_things", "onLoadOtb", file);
-    } catch(std::exception& e) {
-        g_logger.error(stdext::format("Failed to load '%s' (OTB file): %s", file, e.what()));
+        addItemType(itemType, otb.itemTypes);
+
+        const uint16 clientId = itemType->getClientId();
+        if(unlikely(clientId >= otb.reverseItemTypes.size()))
+            otb.reverseItemTypes.resize(clientId + 1);
+        otb.reverseItemTypes[clientId] = itemType;
     }
 }
 
+void ThingTypeManager::setOtb(OtbAssets& otb)
+{
+    for(auto& itemType : otb.itemTypes) {
+        if(!itemType)
+            itemType = m_nullItemType;
+    }
+    for(auto& itemType : otb.reverseItemTypes) {
+        if(!itemType)
+            itemType = m_nullItemType;
+    }
+
+    m_itemTypes.swap(otb.itemTypes);
+    m_reverseItemTypes.swap(otb.reverseItemTypes);
+    m_otbMajorVersion = otb.majorVersion;
+    m_otbMinorVersion = otb.minorVersion;
+    m_otbLoaded = true;
+    g_lua.callGlobalField("g_things", "onLoadOtb", otb.file);
+}
+
 void ThingTypeManager::loadXml(const std::string& file)
 {
     try {
         if(!isOtbLoaded())
             stdext::throw_exception("OTB must be loaded before XML");
 
-        TiXmlDocument doc;
-        doc.Parse(g_resources.readFileContents(file).c_str());
-        if(doc.Error())
-            stdext::throw_exception(stdext::format("failed to parse '%s': '%s'", file, doc.ErrorDesc()));
-
-        TiXmlElement* root = doc.FirstChildElement();
-        if(!root || root->ValueTStr() != "items")
-            stdext::throw_exception("invalid root tag name");
-
-        for(TiXmlElement* element = root->FirstChildElement(); element; element = element->NextSiblingElement()) {
-            if(unlikely(element->ValueTStr() != "item"))
-                continue;
-
-            const uint16 id = element->readType<uint16>("id");
-            if(id != 0) {
-                std::vector<std::string> s_ids = stdext::split(element->Attribute("id"), ";");
-                for(const std::string& s : s_ids) {
-                    std::vector<int32> ids = stdext::split<int32>(s, "-");
-                    if(ids.size() > 1) {
-                        int32 i = ids[0];
-                        while(i <= ids[1])
-                            parseItemType(++i, element);
-                    } else
-                        parseItemType(atoi(s.c_str()), element);
-                }
-            } else {
-                std::vector<int32> begin = stdext::split<int32>(element->Attribute("fromid"), ";");
-                std::vector<int32> end = stdext::split<int32>(element->Attribute("toid"), ";");
-                if(begin[0] && begin.size() == end.size()) {
-                    const size_t size = begin.size();
-                    for(size_t i = 0; i < size; ++i)
-                        while(begin[i] <= end[i])
-                            parseItemType(++begin[i], element);
-                }
-            }
-        }
-
-        doc.Clear();
+        unserializeXml(*parseXml(file), m_itemTypes);
         m_xmlLoaded = true;
         g_logger.debug("items.xml read successfully.");
     } catch(std::exception& e) {
@@ -273,7 +509,58 @@ void ThingTypeManager::loadXml(const std::string& file)
     }
 }
 
+std::shared_ptr<TiXmlDocument> ThingTypeManager::parseXml(const std::string& file)
+{
+    auto doc = std::make_shared<TiXmlDocument>();
+    doc->Parse(g_resources.readFileContents(file).c_str());
+    if(doc->Error())
+        stdext::throw_exception(stdext::format("failed to parse '%s': '%s'", file, doc->ErrorDesc()));
+    return doc;
+}
+
+void ThingTypeManager::unserializeXml(TiXmlDocument& doc, ItemTypeList& itemTypes)
+{
+    TiXmlElement* root = doc.FirstChildElement();
+    if(!root || root->ValueTStr() != "items")
+        stdext::throw_exception("invalid root tag name");
+
+    for(TiXmlElement* element = root->FirstChildElement(); element; element = element->NextSiblingElement()) {
+        if(unlikely(element->ValueTStr() != "item"))
+            continue;
+
+        const uint16 id = element->readType<uint16>("id");
+        if(id != 0) {
+            std::vector<std::string> s_ids = stdext::split(element->Attribute("id"), ";");
+            for(const std::string& s : s_ids) {
+                std::vector<int32> ids = stdext::split<int32>(s, "-");
+                if(ids.size() > 1) {
+                    int32 i = ids[0];
+                    while(i <= ids[1])
+                        parseItemType(++i, element, itemTypes);
+                } else
+                    parseItemType(atoi(s.c_str()), element, itemTypes);
+            }
+        } else {
+            std::vector<int32> begin = stdext::split<int32>(element->Attribute("fromid"), ";");
+            std::vector<int32> end = stdext::split<int32>(element->Attribute("toid"), ";");
+            if(begin[0] && begin.size() == end.size()) {
+                const size_t size = begin.size();
+                for(size_t i = 0; i < size; ++i)
+                    while(begin[i] <= end[i])
+                        parseItemType(++begin[i], element, itemTypes);
+            }
+        }
+    }
+
+    doc.Clear();
+}
+
 void ThingTypeManager::parseItemType(uint16 serverId, TiXmlElement* elem)
+{
+    parseItemType(serverId, elem, m_itemTypes);
+}
+
+void ThingTypeManager::parseItemType(uint16 serverId, TiXmlElement* elem, ItemTypeList& itemTypes)
 {
     ItemTypePtr itemType = nullptr;
 
@@ -281,9 +568,11 @@ void ThingTypeManager::parseItemType(uint16 serverId, TiXmlElement* elem)
         serverId -= 30000;
         itemType = ItemTypePtr(new ItemType);
         itemType->setServerId(serverId);
-        addItemType(itemType);
-    } else
-        itemType = getItemType(serverId);
+        addItemType(itemType, itemTypes);
+    } else if(serverId < itemTypes.size() && itemTypes[serverId] && itemTypes[serverId] != m_nullItemType)
+        itemType = itemTypes[serverId];
+    else
+        return;
 
     itemType->setName(elem->Attribute("name"));
     for(TiXmlElement* attrib = elem->FirstChildElement(); attrib; attrib = attrib->NextSiblingElement()) {
@@ -327,6 +616,15 @@ void ThingTypeManager::addItemType(const ItemTypePtr& itemType)
     m_itemTypes[id] = itemType;
 }
 
+void ThingTypeManager::addItemType(const ItemTypePtr& itemType, ItemTypeList& itemTypes)
+{
+    const uint16 id = itemType->getServerId();
+    if(unlikely(id >= itemTypes.size()))
+        itemTypes.resize(id + 1);
+
+    itemTypes[id] = itemType;
+}
+
 const ItemTypePtr& ThingTypeManager::findItemTypeByClientId(const uint16 id)
 {
     if(id == 0 || id >= m_reverseItemTypes.size())
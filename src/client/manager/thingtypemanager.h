@@ -28,6 +28,7 @@
 
 #include <client/thing/type/itemtype.h>
 #include <client/thing/type/thingtype.h>
+#include <client/thing/type/thingtypecache.h>
 
 class ThingTypeManager
 {
@@ -41,6 +42,10 @@ public:
     void loadXml(const std::string& file);
     void parseItemType(uint16 id, TiXmlElement* elem);
 
+    // loads in worker threads, results are published together before g_things.onAssetsLoaded
+    void loadAssets(const std::string& datFile, const std::string& sprFile, const std::string& otbFile, const std::string& xmlFile);
+    bool isLoadingAssets() { return m_assetsLoad != nullptr; }
+
     void saveDat(const std::string& fileName);
 
     void addItemType(const ItemTypePtr& itemType);
@@ -68,14 +73,60 @@ public:
     uint32 getOtbMinorVersion() { return m_otbMinorVersion; }
     uint16 getContentRevision() { return m_contentRevision; }
 
+    // keeps a compiled copy of the dat in the write dir
+    void setDatCacheEnabled(bool enable) { m_datCacheEnabled = enable; }
+    bool isDatCacheEnabled() { return m_datCacheEnabled; }
+
     bool isDatLoaded() { return m_datLoaded; }
     bool isXmlLoaded() { return m_xmlLoaded; }
     bool isOtbLoaded() { return m_otbLoaded; }
 
     bool isValidDatId(const uint16 id, const ThingCategory category) { return id >= 1 && id < m_thingTypes[category].size(); }
     bool isValidOtbId(const uint16 id) { return id >= 1 && id < m_itemTypes.size(); }
+    bool isValidOtbItemId(const uint16 id) { return isValidOtbId(id) && m_itemTypes[id] != m_nullItemType; }
 
 private:
+    struct DatAssets {
+        std::string file;
+        int clientVersion{ 0 };
+        uint32 signature{ 0 };
+        ThingTypeList thingTypes[ThingLastCategory];
+        // the cache is rewritten and warnings are logged only when the assets get published
+        bool saveCache{ false };
+        std::string cacheFile;
+        ThingTypeCache::Key cacheKey;
+        std::vector<std::string> warnings;
+    };
+
+    struct OtbAssets {
+        std::string file;
+        uint32 majorVersion{ 0 };
+        uint32 minorVersion{ 0 };
+        ItemTypeList itemTypes;
+        ItemTypeList reverseItemTypes;
+    };
+
+    struct AssetsLoad;
+    using AssetsLoadPtr = std::shared_ptr<AssetsLoad>;
+
+    // the unserialize functions only fill the given assets, so they can run in worker threads,
+    // the set functions publish them in the main thread
+    void unserializeDat(const std::string& file, DatAssets& dat);
+    void setDat(DatAssets& dat);
+    bool loadDatCache(const std::string& file, const ThingTypeCache::Key& key, DatAssets& dat);
+    std::string getDatCacheFile(const std::string& file, int clientVersion);
+
+    void unserializeOtb(const std::string& file, OtbAssets& otb);
+    void setOtb(OtbAssets& otb);
+
+    std::shared_ptr<TiXmlDocument> parseXml(const std::string& file);
+    void unserializeXml(TiXmlDocument& doc, ItemTypeList& itemTypes);
+    void parseItemType(uint16 serverId, TiXmlElement* elem, ItemTypeList& itemTypes);
+    void addItemType(const ItemTypePtr& itemType, ItemTypeList& itemTypes);
+
+    void finishAssetsStep(const AssetsLoadPtr& load, const std::string& file);
+    void publishAssets(const AssetsLoadPtr& load);
+
     ThingTypeList m_thingTypes[ThingLastCategory];
     ItemTypeList m_reverseItemTypes;
     ItemTypeList m_itemTypes;
@@ -84,6 +135,8 @@ private:
     ItemTypePtr m_nullItemType;
 
     bool m_datLoaded;
+    bool m_datCacheEnabled{ false };
+    AssetsLoadPtr m_assetsLoad;
     bool m_xmlLoaded;
     bool m_otbLoaded;
 
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <client/manager/walkmanager.h>
+#include <client/thing/creature/creature.h>
+
+#include <framework/core/clock.h>
+#include <framework/core/eventdispatcher.h>
+
+WalkManager g_walks;
+
+void WalkManager::init()
+{
+    g_dispatcher.addPollCallback([this] { poll(); });
+}
+
+void WalkManager::terminate()
+{
+    for(const Walk& walk : m_walks)
+        walk.creature->m_walkSlot = -1;
+    m_walks.clear();
+    m_idleCount = 0;
+}
+
+void WalkManager::poll()
+{
+    const ticks_t now = g_clock.millis();
+
+    // creatures may start walking while others are updated, so new entries are appended
+    // to the array and only idle ones are removed, after the whole pass
+    for(size_t i = 0; i < m_walks.size(); ++i) {
+        if(m_walks[i].state == WalkIdle || m_walks[i].ticks > now)
+            continue;
+
+        const CreaturePtr creature = m_walks[i].creature;
+        const WalkState state = m_walks[i].state;
+        m_walks[i].state = WalkIdle;
+        ++m_idleCount;
+
+        if(state == WalkUpdating)
+            creature->nextWalkUpdate();
+        else {
+            creature->m_totalWalkedPixels = 0;
+            creature->m_walkAnimationPhase = 0;
+        }
+    }
+
+    if(m_idleCount > 0)
+        removeIdle();
+}
+
+void WalkManager::scheduleUpdate(const CreaturePtr& creature, int delay)
+{
+    schedule(creature, delay, WalkUpdating);
+}
+
+void WalkManager::scheduleFinish(const CreaturePtr& creature, int delay)
+{
+    schedule(creature, delay, WalkFinishing);
+}
+
+void WalkManager::cancel(Creature* creature)
+{
+    if(creature->m_walkSlot < 0)
+        return;
+
+    Walk& walk = m_walks[creature->m_walkSlot];
+    if(walk.state != WalkIdle) {
+        walk.state = WalkIdle;
+        ++m_idleCount;
+    }
+}
+
+void WalkManager::schedule(const CreaturePtr& creature, int delay, WalkState state)
+{
+    const ticks_t ticks = g_clock.millis() + delay;
+    if(creature->m_walkSlot >= 0) {
+        Walk& walk = m_walks[creature->m_walkSlot];
+        if(walk.state == WalkIdle)
+            --m_idleCount;
+        walk.ticks = ticks;
+        walk.state = state;
+        return;
+    }
+
+    creature->m_walkSlot = m_walks.size();
+    m_walks.push_back({ creature, ticks, state });
+}
+
+void WalkManager::removeIdle()
+{
+    size_t count = 0;
+    for(size_t i = 0; i < m_walks.size(); ++i) {
+        Walk& walk = m_walks[i];
+        if(walk.state == WalkIdle) {
+            walk.creature->m_walkSlot = -1;
+            continue;
+        }
+
+        if(i != count) {
+            walk.creature->m_walkSlot = count;
+            m_walks[count] = std::move(walk);
+        }
+        ++count;
+    }
+
+    m_walks.resize(count);
+    m_idleCount = 0;
+}
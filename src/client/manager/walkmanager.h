@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef WALKMANAGER_H
+#define WALKMANAGER_H
+
+#include <client/declarations.h>
+
+// Advances every walking creature once per frame from a dense array, instead of
+// keeping one scheduled dispatcher event per creature and per pixel step.
+class WalkManager
+{
+public:
+    void init();
+    void terminate();
+    void poll();
+
+    // next walk update of a walking creature, replaces any pending update or finish
+    void scheduleUpdate(const CreaturePtr& creature, int delay);
+    // resets the walk animation once the creature stops walking for a while
+    void scheduleFinish(const CreaturePtr& creature, int delay);
+    void cancel(Creature* creature);
+
+    int getCount() { return m_walks.size() - m_idleCount; }
+
+private:
+    enum WalkState : uint8 {
+        WalkIdle,
+        WalkUpdating,
+        WalkFinishing
+    };
+
+    struct Walk {
+        CreaturePtr creature;
+        ticks_t ticks;
+        WalkState state;
+    };
+
+    void schedule(const CreaturePtr& creature, int delay, WalkState state);
+    void removeIdle();
+
+    std::vector<Walk> m_walks;
+    int m_idleCount{ 0 };
+};
+
+extern WalkManager g_walks;
+
+#endif
@@ -36,6 +36,8 @@
 #include <framework/core/application.h>
 #include <framework/core/eventdispatcher.h>
 
+#include <queue>
+
 Map g_map;
 TilePtr Map::m_nulltile;
 
@@ -109,6 +111,8 @@ void Map::clean()
         m_tileBlocks[i].clear();
 
     m_waypoints.clear();
+    m_itemIndex.clear();
+    closeOtcmStream();
 
     g_towns.clear();
     g_houses.clear();
@@ -393,6 +397,10 @@ void Map::cleanTile(const Position& pos)
     if(!pos.isMapPosition())
         return;
 
+    // the server describes this tile now, streaming must not evict it
+    if(m_otcmFile)
+        releaseOtcmTile(pos);
+
     auto it = m_tileBlocks[pos.z].find(getBlockIndex(pos));
     if(it != m_tileBlocks[pos.z].end()) {
         TileBlock& block = it->second;
@@ -487,6 +495,9 @@ void Map::endGhostMode()
 
 std::map<Position, ItemPtr> Map::findItemsById(uint16 clientId, uint32 max)
 {
+    if(m_itemIndexEnabled)
+        return findIndexedItems(clientId, nullptr, -1, max);
+
     std::map<Position, ItemPtr> ret;
     uint32 count = 0;
     for(uint8_t z = 0; z <= MAX_Z; ++z) {
@@ -509,6 +520,127 @@ std::map<Position, ItemPtr> Map::findItemsById(uint16 clientId, uint32 max)
     return ret;
 }
 
+std::map<Position, ItemPtr> Map::findItemsByIdInArea(uint16 clientId, const Rect& area, int floor, uint32 max)
+{
+    if(m_itemIndexEnabled)
+        return findIndexedItems(clientId, &area, floor, max);
+
+    std::map<Position, ItemPtr> ret;
+    for(int z = floor < 0 ? 0 : floor; z <= (floor < 0 ? MAX_Z : std::min<int>(floor, MAX_Z)); ++z) {
+        for(int y = area.top(); y <= area.bottom(); ++y) {
+            for(int x = area.left(); x <= area.right(); ++x) {
+                const TilePtr& tile = getTile(Position(x, y, z));
+                if(!tile)
+                    continue;
+
+                for(const ThingPtr& thing : tile->getThings()) {
+                    if(thing->isItem() && thing->getId() == clientId) {
+                        ret.insert(std::make_pair(tile->getPosition(), thing->static_self_cast<Item>()));
+                        if(ret.size() >= max)
+                            return ret;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    return ret;
+}
+
+std::map<Position, ItemPtr> Map::findIndexedItems(uint16 clientId, const Rect* area, int floor, uint32 max)
+{
+    std::map<Position, ItemPtr> ret;
+
+    const auto indexIt = m_itemIndex.find(clientId);
+    if(indexIt == m_itemIndex.end())
+        return ret;
+
+    // positions are validated here, tiles dropped as a whole never report their items back
+    auto& positions = indexIt->second;
+    for(auto it = positions.begin(); it != positions.end();) {
+        const Position& pos = *it;
+        if((floor >= 0 && pos.z != floor) || (area && !area->contains(Point(pos.x, pos.y)))) {
+            ++it;
+            continue;
+        }
+
+        ItemPtr found;
+        if(const TilePtr& tile = getTile(pos)) {
+            for(const ThingPtr& thing : tile->getThings()) {
+                if(thing->isItem() && thing->getId() == clientId) {
+                    found = thing->static_self_cast<Item>();
+                    break;
+                }
+            }
+        }
+
+        if(!found) {
+            it = positions.erase(it);
+            continue;
+        }
+
+        ret.insert(std::make_pair(pos, found));
+        if(ret.size() >= max)
+            break;
+        ++it;
+    }
+
+    if(positions.empty())
+        m_itemIndex.erase(indexIt);
+
+    return ret;
+}
+
+void Map::setItemIndexEnabled(bool enable)
+{
+    if(m_itemIndexEnabled == enable)
+        return;
+
+    m_itemIndexEnabled = enable;
+    m_itemIndex.clear();
+    if(!enable)
+        return;
+
+    for(uint8_t z = 0; z <= MAX_Z; ++z) {
+        for(const auto& pair : m_tileBlocks[z]) {
+            for(const TilePtr& tile : pair.second.getTiles()) {
+                if(!tile)
+                    continue;
+
+                for(const ThingPtr& thing : tile->getThings()) {
+                    if(thing->isItem())
+                        m_itemIndex[thing->getId()].insert(tile->getPosition());
+                }
+            }
+        }
+    }
+}
+
+void Map::indexItem(uint16 clientId, const Position& pos)
+{
+    m_itemIndex[clientId].insert(pos);
+}
+
+void Map::unindexItem(uint16 clientId, const Position& pos)
+{
+    const auto it = m_itemIndex.find(clientId);
+    if(it == m_itemIndex.end())
+        return;
+
+    // the tile may still hold another item with the same id
+    if(const TilePtr& tile = getTile(pos)) {
+        for(const ThingPtr& thing : tile->getThings()) {
+            if(thing->isItem() && thing->getId() == clientId)
+                return;
+        }
+    }
+
+    it->second.erase(pos);
+    if(it->second.empty())
+        m_itemIndex.erase(it);
+}
+
 void Map::addCreature(const CreaturePtr& creature)
 {
     m_knownCreatures[creature->getId()] = creature;
@@ -587,6 +719,7 @@ void Map::setCentralPosition(const Position& centralPosition)
     m_centralPosition = centralPosition;
 
     removeUnawareThings();
+    updateOtcmStream();
 
     // this fixes local player position when the local player is removed from the map,
     // the local player is removed from the map when there are too many creatures on his tile,
@@ -757,6 +890,7 @@ void Map::setAwareRange(const AwareRange& range)
 {
     m_awareRange = range;
     removeUnawareThings();
+    updateOtcmStream();
 }
 
 uint8 Map::getFirstAwareFloor()
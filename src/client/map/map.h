@@ -34,6 +34,8 @@
 #include <framework/core/clock.h>
 #include <framework/graphics/framebuffer.h>
 
+#include <bitset>
+
 enum OTBM_ItemAttr
 {
     OTBM_ATTR_DESCRIPTION = 1,
@@ -87,7 +89,7 @@ enum OTBM_NodeTypes_t
 
 enum {
     OTCM_SIGNATURE = 0x4D43544F,
-    OTCM_VERSION = 1
+    OTCM_VERSION = 2
 };
 
 enum {
@@ -143,6 +145,12 @@ public:
     bool loadOtcm(const std::string& fileName);
     void saveOtcm(const std::string& fileName);
 
+    // otcm v2 maps are streamed by blocks around the aware range instead of loaded at once
+    void setOtcmStreaming(bool enable) { m_otcmStreaming = enable; }
+    bool isOtcmStreaming() { return m_otcmStreaming; }
+    void setOtcmCacheSize(uint size) { m_otcmCacheSize = size; }
+    uint getOtcmCacheSize() { return m_otcmCacheSize; }
+
     void loadOtbm(const std::string& fileName);
     void saveOtbm(const std::string& fileName);
 
@@ -202,6 +210,13 @@ public:
     void endGhostMode();
 
     std::map<Position, ItemPtr> findItemsById(uint16 clientId, uint32 max);
+    std::map<Position, ItemPtr> findItemsByIdInArea(uint16 clientId, const Rect& area, int floor, uint32 max);
+
+    // optional client id to positions index kept by the tiles, used by the item searches
+    void setItemIndexEnabled(bool enable);
+    bool isItemIndexEnabled() { return m_itemIndexEnabled; }
+    void indexItem(uint16 clientId, const Position& pos);
+    void unindexItem(uint16 clientId, const Position& pos);
 
     // known creature related
     void addCreature(const CreaturePtr& creature);
@@ -240,7 +255,34 @@ public:
     bool isDrawingFloatingEffects() { return m_floatingEffect; }
 
 private:
+    struct OtcmBlock
+    {
+        Position pos;
+        uint32 offset;
+        uint32 size;
+        uint32 rawSize;
+        std::vector<uint8> data;
+        std::list<uint64>::iterator lruIt;
+        // tiles created from the file that the server has not described since
+        std::bitset<BLOCK_SIZE * BLOCK_SIZE> tiles;
+        bool cached{ false };
+        // every tile of the block is loaded
+        bool resident{ false };
+    };
+
     void removeUnawareThings();
+    std::map<Position, ItemPtr> findIndexedItems(uint16 clientId, const Rect* area, int floor, uint32 max);
+
+    void openOtcmStream(const FileStreamPtr& fin, const std::string& fileName);
+    void closeOtcmStream();
+    void updateOtcmStream();
+    bool readOtcmBlock(OtcmBlock& block, bool compressed, std::vector<uint8>& data);
+    // returns false when unaware tiles were left out
+    bool insertOtcmBlock(OtcmBlock& block, const std::vector<uint8>& data, bool awareOnly);
+    void releaseOtcmTile(const Position& pos);
+    void evictOtcmBlock(OtcmBlock& block);
+
+    static uint64 getOtcmBlockKey(const Position& pos) { return static_cast<uint64>(pos.z) << 32 | ((pos.y / BLOCK_SIZE) * (65536 / BLOCK_SIZE) + pos.x / BLOCK_SIZE); }
 
     uint16 getBlockIndex(const Position& pos) { return ((pos.y / BLOCK_SIZE) * (65536 / BLOCK_SIZE)) + (pos.x / BLOCK_SIZE); }
 
@@ -271,6 +313,16 @@ private:
     static TilePtr m_nulltile;
 
     bool m_floatingEffect{ true };
+
+    std::unordered_map<uint16, std::unordered_set<Position, Position::Hasher>> m_itemIndex;
+    bool m_itemIndexEnabled{ false };
+
+    FileStreamPtr m_otcmFile;
+    std::string m_otcmFileName;
+    std::unordered_map<uint64, OtcmBlock> m_otcmBlocks;
+    std::list<uint64> m_otcmLru;
+    uint m_otcmCacheSize{ 256 };
+    bool m_otcmStreaming{ false };
 };
 
 extern Map g_map;
@@ -24,6 +24,7 @@
 #include <client/map/tile.h>
 
 #include <zlib.h>
+#include <framework/core/asyncdispatcher.h>
 #include <framework/core/filestream.h>
 #include <framework/core/resourcemanager.h>
 #include <framework/graphics/framebuffermanager.h>
@@ -78,10 +79,36 @@ void MinimapBlock::update()
 
 void MinimapBlock::updateTile(int x, int y, const MinimapTile& tile)
 {
-    if(m_tiles[getTileIndex(x, y)].color != tile.color)
+    MinimapTile& current = m_tiles[getTileIndex(x, y)];
+    if(current == tile)
+        return;
+
+    if(current.color != tile.color)
         m_mustUpdate = true;
 
-    m_tiles[getTileIndex(x, y)] = tile;
+    current = tile;
+    changed();
+}
+
+void MinimapBlock::setCompressedTiles(std::vector<uint8>&& data, bool loaded)
+{
+    m_compressedTiles = std::move(data);
+    m_loaded = loaded;
+}
+
+bool MinimapBlock::decompress()
+{
+    m_loaded = true;
+    m_mustUpdate = true;
+
+    ulong destLen = sizeof(m_tiles);
+    const int ret = uncompress(reinterpret_cast<uchar*>(m_tiles.data()), &destLen, m_compressedTiles.data(), m_compressedTiles.size());
+    if(ret != Z_OK || destLen != sizeof(m_tiles)) {
+        m_tiles.fill(MinimapTile());
+        changed();
+        return false;
+    }
+    return true;
 }
 
 void Minimap::init()
@@ -90,6 +117,9 @@ void Minimap::init()
 
 void Minimap::terminate()
 {
+    // the async dispatcher is terminated by now, it ran every queued compression task
+    // before stopping, so this only writes the file the main thread never got to
+    waitPendingSave();
     clean();
 }
 
@@ -97,6 +127,15 @@ void Minimap::clean()
 {
     for(int i = 0; i <= MAX_Z; ++i)
         m_tileBlocks[i].clear();
+    ++m_generation;
+}
+
+MinimapBlock& Minimap::getBlock(const Position& pos)
+{
+    MinimapBlock& block = m_tileBlocks[pos.z][getBlockIndex(pos)];
+    if(unlikely(!block.isLoaded()) && !block.decompress())
+        g_logger.error(stdext::format("failed to decompress minimap block at %s", stdext::to_string(pos)));
+    return block;
 }
 
 void Minimap::draw(const Rect& screenRect, const Position& mapCenter, float scale, const Color& color)
@@ -289,6 +328,7 @@ bool Minimap::loadImage(const std::string& fileName, const Position& topLeft, fl
                     tile.color = c;
                     tile.flags = flags;
                     block.mustUpdate();
+                    block.changed();
                 }
             }
         }
@@ -306,6 +346,9 @@ void Minimap::saveImage(const std::string&, const Rect&)
 
 bool Minimap::loadOtmm(const std::string& fileName)
 {
+    // the file may still be written by a previous save
+    waitPendingSave();
+
     try {
         FileStreamPtr fin = g_resources.openFile(fileName);
         if(!fin)
@@ -333,10 +376,7 @@ bool Minimap::loadOtmm(const std::string& fileName)
 
         fin->seek(start);
 
-        const uint blockSize = MMBLOCK_SIZE * MMBLOCK_SIZE * sizeof(MinimapTile);
-        std::vector<uchar> compressBuffer(compressBound(blockSize));
-        std::vector<uchar> decompressBuffer(blockSize);
-
+        // only the block headers are read here, tiles are decompressed the first time a block is used
         while(true) {
             Position pos;
             pos.x = fin->getU16();
@@ -347,16 +387,13 @@ bool Minimap::loadOtmm(const std::string& fileName)
             if(!pos.isValid() || pos.z >= MAX_Z + 1)
                 break;
 
-            MinimapBlock& block = getBlock(pos);
-            const ulong len = fin->getU16();
-            ulong destLen = blockSize;
-            fin->read(compressBuffer.data(), len);
-            const int ret = uncompress(decompressBuffer.data(), &destLen, compressBuffer.data(), len);
-            if(ret != Z_OK || destLen != blockSize)
+            const uint len = fin->getU16();
+            std::vector<uint8> data(len);
+            if(fin->read(data.data(), len) != static_cast<int>(len))
                 break;
 
-            memcpy(&block.getTiles(), decompressBuffer.data(), blockSize);
-            block.mustUpdate();
+            MinimapBlock& block = m_tileBlocks[pos.z][getBlockIndex(pos)];
+            block.setCompressedTiles(std::move(data), false);
             block.justSaw();
         }
 
@@ -370,10 +407,81 @@ bool Minimap::loadOtmm(const std::string& fileName)
 
 void Minimap::saveOtmm(const std::string& fileName)
 {
-    try {
-        stdext::timer saveTimer;
+    waitPendingSave();
+
+    const auto save = std::make_shared<PendingSave>();
+    save->fileName = fileName;
+    save->generation = m_generation;
+    save->group = std::make_shared<AsyncTaskGroup>();
+
+    // blocks not changed since they were read or saved keep their compressed tiles,
+    // the other ones are copied so the game can keep changing them meanwhile
+    for(uint8_t z = 0; z <= MAX_Z; ++z) {
+        for(auto& it : m_tileBlocks[z]) {
+            MinimapBlock& block = it.second;
+            if(!block.wasSeen())
+                continue;
+
+            SavedBlock savedBlock;
+            savedBlock.pos = getIndexPosition(it.first, z);
+            savedBlock.version = block.getVersion();
+            if(!block.getCompressedTiles().empty())
+                savedBlock.data = block.getCompressedTiles();
+            else
+                savedBlock.tiles.assign(block.getTiles().begin(), block.getTiles().end());
+            save->blocks.push_back(std::move(savedBlock));
+        }
+    }
+
+    m_pendingSave = save;
+
+    for(const SavedBlock& savedBlock : save->blocks) {
+        if(!savedBlock.tiles.empty())
+            ++save->pending;
+    }
+
+    if(save->pending == 0) {
+        finishSave(save);
+        return;
+    }
+
+    for(SavedBlock& savedBlock : save->blocks) {
+        if(savedBlock.tiles.empty())
+            continue;
 
-        FileStreamPtr fin = g_resources.createFile(fileName);
+        save->group->schedule([this, save, &savedBlock] {
+            const int COMPRESS_LEVEL = 3;
+            const uint blockSize = savedBlock.tiles.size() * sizeof(MinimapTile);
+
+            ulong len = compressBound(blockSize);
+            savedBlock.data.resize(len);
+            if(compress2(savedBlock.data.data(), &len, reinterpret_cast<const uchar*>(savedBlock.tiles.data()), blockSize, COMPRESS_LEVEL) != Z_OK)
+                len = 0;
+            savedBlock.data.resize(len);
+
+            // the last compressed block hands the file writing back to the main thread
+            if(--save->pending == 0)
+                g_asyncDispatcher.dispatchToMain([this, save] { finishSave(save); });
+        }, AsyncDispatcher::LowPriority);
+    }
+
+    // once the pool is stopped the blocks were compressed inline and main thread tasks
+    // are no longer polled, so the file is written right away
+    if(g_asyncDispatcher.getWorkerCount() == 0)
+        waitPendingSave();
+}
+
+void Minimap::finishSave(const std::shared_ptr<PendingSave>& save)
+{
+    if(save->written)
+        return;
+
+    save->written = true;
+    if(m_pendingSave == save)
+        m_pendingSave = nullptr;
+
+    try {
+        FileStreamPtr fin = g_resources.createFile(save->fileName);
         fin->cache();
 
         //TODO: compression flag with zlib
@@ -394,28 +502,15 @@ void Minimap::saveOtmm(const std::string& fileName)
         fin->addU16(start);
         fin->seek(start);
 
-        const uint blockSize = MMBLOCK_SIZE * MMBLOCK_SIZE * sizeof(MinimapTile);
-        std::vector<uchar> compressBuffer(compressBound(blockSize));
-        const int COMPRESS_LEVEL = 3;
-
-        for(uint8_t z = 0; z <= MAX_Z; ++z) {
-            for(auto& it : m_tileBlocks[z]) {
-                const int index = it.first;
-                MinimapBlock& block = it.second;
-                if(!block.wasSeen())
-                    continue;
-
-                const Position pos = getIndexPosition(index, z);
-                fin->addU16(pos.x);
-                fin->addU16(pos.y);
-                fin->addU8(pos.z);
+        for(const SavedBlock& savedBlock : save->blocks) {
+            if(savedBlock.data.empty())
+                continue;
 
-                ulong len = blockSize;
-                const int ret = compress2(compressBuffer.data(), &len, (uchar*)&block.getTiles(), blockSize, COMPRESS_LEVEL);
-                assert(ret == Z_OK);
-                fin->addU16(len);
-                fin->write(compressBuffer.data(), len);
-            }
+            fin->addU16(savedBlock.pos.x);
+            fin->addU16(savedBlock.pos.y);
+            fin->addU8(savedBlock.pos.z);
+            fin->addU16(savedBlock.data.size());
+            fin->write(savedBlock.data.data(), savedBlock.data.size());
         }
 
         // end of file
@@ -430,4 +525,27 @@ void Minimap::saveOtmm(const std::string& fileName)
     } catch(stdext::exception& e) {
         g_logger.error(stdext::format("failed to save OTMM minimap: %s", e.what()));
     }
+
+    // blocks that didn't change while saving can reuse what was just compressed
+    if(save->generation != m_generation)
+        return;
+
+    for(SavedBlock& savedBlock : save->blocks) {
+        if(savedBlock.tiles.empty() || savedBlock.data.empty())
+            continue;
+
+        const auto it = m_tileBlocks[savedBlock.pos.z].find(getBlockIndex(savedBlock.pos));
+        if(it != m_tileBlocks[savedBlock.pos.z].end() && it->second.getVersion() == savedBlock.version)
+            it->second.setCompressedTiles(std::move(savedBlock.data), true);
+    }
+}
+
+void Minimap::waitPendingSave()
+{
+    if(!m_pendingSave)
+        return;
+
+    const auto save = m_pendingSave;
+    save->group->wait();
+    finishSave(save);
 }
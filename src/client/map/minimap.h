@@ -23,6 +23,7 @@
 #ifndef MINIMAP_H
 #define MINIMAP_H
 
+#include <framework/core/declarations.h>
 #include <framework/graphics/declarations.h>
 #include <client/declarations.h>
 
@@ -58,18 +59,31 @@ public:
     void update();
     void updateTile(int x, int y, const MinimapTile& tile);
     MinimapTile& getTile(int x, int y) { return m_tiles[getTileIndex(x, y)]; }
-    void resetTile(int x, int y) { m_tiles[getTileIndex(x, y)] = MinimapTile(); }
+    void resetTile(int x, int y) { m_tiles[getTileIndex(x, y)] = MinimapTile(); changed(); }
     uint getTileIndex(int x, int y) { return ((y % MMBLOCK_SIZE) * MMBLOCK_SIZE) + (x % MMBLOCK_SIZE); }
     const TexturePtr& getTexture() { return m_texture; }
     std::array<MinimapTile, MMBLOCK_SIZE* MMBLOCK_SIZE>& getTiles() { return m_tiles; }
     void mustUpdate() { m_mustUpdate = true; }
     void justSaw() { m_wasSeen = true; }
     bool wasSeen() { return m_wasSeen; }
+
+    // blocks read from an otmm keep their compressed tiles until they are first used,
+    // unchanged blocks keep them afterwards too so saving doesn't compress them again
+    void setCompressedTiles(std::vector<uint8>&& data, bool loaded);
+    const std::vector<uint8>& getCompressedTiles() { return m_compressedTiles; }
+    bool decompress();
+    bool isLoaded() { return m_loaded; }
+    void changed() { m_compressedTiles.clear(); ++m_version; }
+    uint getVersion() { return m_version; }
+
 private:
     TexturePtr m_texture;
     std::array<MinimapTile, MMBLOCK_SIZE* MMBLOCK_SIZE> m_tiles;
+    std::vector<uint8> m_compressedTiles;
+    uint m_version{ 0 };
     bool m_mustUpdate{ true };
     bool m_wasSeen{ false };
+    bool m_loaded{ true };
 };
 
 #pragma pack(pop)
@@ -97,8 +111,30 @@ public:
 
 private:
     Rect calcMapRect(const Rect& screenRect, const Position& mapCenter, float scale);
+    struct SavedBlock
+    {
+        Position pos;
+        uint version;
+        std::vector<MinimapTile> tiles;
+        std::vector<uint8> data;
+    };
+
+    // blocks are compressed by the workers against a snapshot and written once all are done
+    struct PendingSave
+    {
+        std::string fileName;
+        uint generation;
+        std::vector<SavedBlock> blocks;
+        AsyncTaskGroupPtr group;
+        std::atomic<int> pending{ 0 };
+        bool written{ false };
+    };
+
+    void finishSave(const std::shared_ptr<PendingSave>& save);
+    void waitPendingSave();
+
     bool hasBlock(const Position& pos) { return m_tileBlocks[pos.z].find(getBlockIndex(pos)) != m_tileBlocks[pos.z].end(); }
-    MinimapBlock& getBlock(const Position& pos) { return m_tileBlocks[pos.z][getBlockIndex(pos)]; }
+    MinimapBlock& getBlock(const Position& pos);
     Point getBlockOffset(const Point& pos)
     {
         return Point(pos.x - pos.x % MMBLOCK_SIZE,
@@ -111,6 +147,8 @@ private:
     }
     uint getBlockIndex(const Position& pos) { return ((pos.y / MMBLOCK_SIZE) * (65536 / MMBLOCK_SIZE)) + (pos.x / MMBLOCK_SIZE); }
     std::unordered_map<uint, MinimapBlock> m_tileBlocks[MAX_Z + 1];
+    std::shared_ptr<PendingSave> m_pendingSave;
+    uint m_generation{ 0 };
 };
 
 extern Minimap g_minimap;
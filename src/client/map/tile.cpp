@@ -149,6 +149,9 @@ void Tile::addThing(const ThingPtr& thing, int stackPos)
     thing->setPosition(m_position);
     thing->onAppear();
 
+    if(thing->isItem() && g_map.isItemIndexEnabled())
+        g_map.indexItem(thing->getId(), m_position);
+
     g_map.notificateTileUpdate(thing->getPosition());
 }
 
@@ -177,6 +180,9 @@ bool Tile::removeThing(const ThingPtr thing)
 
     m_things.erase(it);
 
+    if(thing->isItem() && g_map.isItemIndexEnabled())
+        g_map.unindexItem(thing->getId(), m_position);
+
     if(checkForDetachableThing()) unselect();
 
     thing->onDisappear();
@@ -30,11 +30,13 @@
 #include <client/manager/shadermanager.h>
 
 #include <framework/core/declarations.h>
+#include <framework/core/profiler.h>
 #include <framework/graphics/framebuffermanager.h>
 #include <framework/graphics/graphics.h>
 
 void MapViewPainter::draw(const MapViewPtr& mapView, const Rect& rect)
 {
+    PROFILE_SCOPE("map draw");
     // update visible tiles cache when needed
     if(mapView->m_mustUpdateVisibleTilesCache)
         mapView->updateVisibleTilesCache();
@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "gamesession.h"
+
+#include <framework/core/eventdispatcher.h>
+#include <client/lua/luavaluecasts.h>
+
+uint32 GameSession::s_onlineCount = 0;
+
+GameSession::~GameSession()
+{
+    setOnline(false);
+}
+
+void GameSession::login(const std::string& host, uint16 port, const std::string& characterName, const std::string& sessionKey)
+{
+    ProtocolGame::login(std::string(), std::string(), host, port, characterName, std::string(), sessionKey);
+}
+
+void GameSession::logout()
+{
+    if(m_online)
+        sendLogout();
+}
+
+void GameSession::walk(Otc::Direction_t direction)
+{
+    switch(direction) {
+    case Otc::North:
+        sendWalkNorth();
+        break;
+    case Otc::East:
+        sendWalkEast();
+        break;
+    case Otc::South:
+        sendWalkSouth();
+        break;
+    case Otc::West:
+        sendWalkWest();
+        break;
+    case Otc::NorthEast:
+        sendWalkNorthEast();
+        break;
+    case Otc::SouthEast:
+        sendWalkSouthEast();
+        break;
+    case Otc::SouthWest:
+        sendWalkSouthWest();
+        break;
+    case Otc::NorthWest:
+        sendWalkNorthWest();
+        break;
+    default:
+        break;
+    }
+}
+
+void GameSession::turn(Otc::Direction_t direction)
+{
+    switch(direction) {
+    case Otc::North:
+        sendTurnNorth();
+        break;
+    case Otc::East:
+        sendTurnEast();
+        break;
+    case Otc::South:
+        sendTurnSouth();
+        break;
+    case Otc::West:
+        sendTurnWest();
+        break;
+    default:
+        break;
+    }
+}
+
+void GameSession::say(const std::string& message)
+{
+    sendTalk(Otc::MESSAGE_SAY, 0, std::string(), message);
+}
+
+void GameSession::onConnect()
+{
+    ProtocolGame::onConnect();
+    callLuaField("onConnect");
+}
+
+void GameSession::disconnect()
+{
+    setOnline(false);
+    ProtocolGame::disconnect();
+}
+
+void GameSession::onError(const boost::system::error_code& error)
+{
+    setOnline(false);
+
+    callLuaField("onError", error.message(), error.value());
+    disconnect();
+}
+
+void GameSession::send(const OutputMessagePtr& outputMessage)
+{
+    // skip ProtocolGame::send, its bot protection is about the local player and g_game
+    Protocol::send(outputMessage);
+}
+
+void GameSession::parseMessage(const InputMessagePtr& msg)
+{
+    ++m_packetCount;
+    m_byteCount += msg->getUnreadSize();
+
+    uint8 opcode = 0;
+    try {
+        while(!msg->eof() && isConnected()) {
+            opcode = msg->getU8();
+            if(!parseOpcode(opcode, msg))
+                break;
+        }
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("GameSession parse message exception (%d bytes unread, last opcode is 0x%02x): %s",
+                                      msg->getUnreadSize(), opcode, e.what()));
+    }
+}
+
+bool GameSession::parseOpcode(uint8 opcode, const InputMessagePtr& msg)
+{
+    switch(opcode) {
+    case Proto::GameServerChallenge: {
+        const uint32 timestamp = msg->getU32();
+        const uint8 random = msg->getU8();
+        sendLoginPacket(timestamp, random);
+        return true;
+    }
+    case Proto::GameServerLoginError:
+        callLuaField("onLoginError", msg->getString());
+        disconnect();
+        return false;
+    case Proto::GameServerLoginWait: {
+        const std::string message = msg->getString();
+        const int time = msg->getU8();
+        callLuaField("onLoginWait", message, time);
+        disconnect();
+        return false;
+    }
+    case Proto::GameServerLoginAdvice:
+        msg->getString();
+        return true;
+    case Proto::GameServerLoginToken:
+        msg->getU8();
+        return true;
+    case Proto::GameServerLoginOrPendingState:
+        sendEnterGame();
+        return true;
+    case Proto::GameServerEnterGame:
+        setOnline(true);
+        return true;
+    case Proto::GameServerLoginSuccess:
+        m_playerId = msg->getU32();
+        m_serverBeat = msg->getU16();
+        msg->getDouble(); // speed formula
+        msg->getDouble();
+        msg->getDouble();
+        msg->getU8(); // can report bugs
+        msg->getU8(); // can change pvp frame
+        msg->getU8(); // expert pvp mode
+        msg->getString(); // store images url
+        msg->getU16(); // coin package size
+        msg->getU8(); // exiva button
+        msg->getU8(); // tournament button
+        setOnline(true);
+        return true;
+    case Proto::GameServerPingBack:
+        // the server is pinging us
+        sendPingBack();
+        return true;
+    case Proto::GameServerPing:
+        // the server answers our ping
+        m_ping = m_pingTimer.elapsed_millis();
+        return true;
+    case Proto::GameServerDeath:
+        msg->getU8(); // death type
+        msg->getU8(); // penalty
+        msg->getU8(); // redemption
+        callLuaField("onDeath");
+        return true;
+    case Proto::GameServerFullMap: {
+        Position position;
+        position.x = msg->getU16();
+        position.y = msg->getU16();
+        position.z = msg->getU8();
+        setPosition(position);
+        return false;
+    }
+    case Proto::GameServerMapTopRow:
+        setPosition(m_position.translatedToDirection(Otc::North));
+        return false;
+    case Proto::GameServerMapRightRow:
+        setPosition(m_position.translatedToDirection(Otc::East));
+        return false;
+    case Proto::GameServerMapBottomRow:
+        setPosition(m_position.translatedToDirection(Otc::South));
+        return false;
+    case Proto::GameServerMapLeftRow:
+        setPosition(m_position.translatedToDirection(Otc::West));
+        return false;
+    default:
+        // the size of everything else depends on game data this session doesn't keep
+        return false;
+    }
+}
+
+void GameSession::setPosition(const Position& position)
+{
+    if(m_position == position)
+        return;
+
+    const Position oldPosition = m_position;
+    m_position = position;
+    callLuaField("onPositionChange", position, oldPosition);
+}
+
+void GameSession::setOnline(bool online)
+{
+    if(m_online == online)
+        return;
+
+    m_online = online;
+    if(online) {
+        ++s_onlineCount;
+
+        // measure the latency and keep the session alive while no scripted actions are sent
+        m_pingEvent = g_dispatcher.cycleEvent([self = static_self_cast<GameSession>()] { self->ping(); }, m_pingDelay);
+        callLuaField("onLogin");
+    } else {
+        --s_onlineCount;
+
+        // the ping event holds a reference to the session
+        if(m_pingEvent) {
+            m_pingEvent->cancel();
+            m_pingEvent = nullptr;
+        }
+    }
+}
+
+void GameSession::ping()
+{
+    // the connection may be closed by the server without an error
+    if(!isConnected()) {
+        setOnline(false);
+        return;
+    }
+
+    m_pingTimer.restart();
+    sendPing();
+}
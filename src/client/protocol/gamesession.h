@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef GAMESESSION_H
+#define GAMESESSION_H
+
+#include "protocolgame.h"
+
+// a lightweight game connection for server load tests: it logs in, keeps the session
+// alive and sends scripted actions, but keeps no full game state, so many of them can run
+// in one process next to the regular client without touching g_game or g_map.
+// each server packet is read opcode by opcode until one whose size depends on game data
+// (things, creatures, tiles) is reached, the rest of that packet is skipped.
+// sessions send through Protocol::send and are therefore not subject to BOT_PROTECTION,
+// which only guards the player's own connection
+// @bindclass
+class GameSession : public ProtocolGame
+{
+public:
+    ~GameSession() override;
+
+    void login(const std::string& host, uint16 port, const std::string& characterName, const std::string& sessionKey);
+    void logout();
+
+    void walk(Otc::Direction_t direction);
+    void turn(Otc::Direction_t direction);
+    void say(const std::string& message);
+
+    void setPingDelay(int delay) { m_pingDelay = delay; }
+    void disconnect() override;
+
+    bool isOnline() { return m_online; }
+    int getPing() { return m_ping; }
+    uint32 getPacketCount() { return m_packetCount; }
+    uint64 getByteCount() { return m_byteCount; }
+    uint32 getPlayerId() { return m_playerId; }
+    uint16 getServerBeat() { return m_serverBeat; }
+    Position getPosition() { return m_position; }
+
+    static uint32 getOnlineCount() { return s_onlineCount; }
+
+protected:
+    void onConnect() override;
+    void onError(const boost::system::error_code& error) override;
+    void parseMessage(const InputMessagePtr& msg) override;
+    void send(const OutputMessagePtr& outputMessage) override;
+
+private:
+    bool parseOpcode(uint8 opcode, const InputMessagePtr& msg);
+    void setPosition(const Position& position);
+    void setOnline(bool online);
+    void ping();
+
+    ScheduledEventPtr m_pingEvent;
+    stdext::timer m_pingTimer;
+    int m_pingDelay{ 1000 };
+    int m_ping{ -1 };
+    uint32 m_packetCount{ 0 };
+    uint64 m_byteCount{ 0 };
+    uint32 m_playerId{ 0 };
+    uint16 m_serverBeat{ 0 };
+    Position m_position;
+    bool m_online{ false };
+
+    static uint32 s_onlineCount;
+};
+
+#endif
@@ -0,0 +1,430 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "packetgenerator.h"
+#include "packetrecorder.h"
+
+#include <client/game.h>
+#include <client/manager/thingtypemanager.h>
+#include <client/map/map.h>
+#include <client/protocol/protocolcodes.h>
+#include <framework/net/outputmessage.h>
+
+namespace
+{
+    // ids in the ranges the server uses for players and monsters
+    constexpr uint32 PLAYER_ID = 0x10000000;
+    constexpr uint32 CREATURE_ID_BASE = 0x40000000;
+
+    // creatures and effects are kept this many tiles away from the aware range border,
+    // so none of them ever has to be described by a map row
+    constexpr int AREA_INSET = 2;
+
+    constexpr uint16 CREATURE_SPEED = 220;
+
+    void addPosition(const OutputMessagePtr& msg, const Position& pos)
+    {
+        msg->addU16(pos.x);
+        msg->addU16(pos.y);
+        msg->addU8(pos.z);
+    }
+
+    void addDouble(const OutputMessagePtr& msg, double value, uint8 precision = 3)
+    {
+        msg->addU8(precision);
+        msg->addU32(static_cast<int32>(value * std::pow(10, precision)) + INT_MAX);
+    }
+}
+
+void PacketGenerator::generate(const std::string& fileName)
+{
+    validate();
+
+    m_random.seed(m_seed);
+    createCreatures();
+
+    const PacketRecorderPtr recorder(new PacketRecorder(fileName));
+    const OutputMessagePtr msg(new OutputMessage);
+
+    addLogin(msg);
+    recorder->addPacket(0, msg->getBuffer());
+
+    const float tickSeconds = m_tickInterval / 1000.0f;
+    float effects = 0, missiles = 0, animatedTexts = 0;
+    uint32 nextFloorChange = m_floorChangeInterval;
+
+    for(uint32 ticks = m_tickInterval; ticks <= static_cast<uint32>(m_duration); ticks += m_tickInterval) {
+        msg->reset();
+
+        if(m_floorChangeInterval > 0 && ticks >= nextFloorChange) {
+            addFloorChange(msg);
+            nextFloorChange += m_floorChangeInterval;
+        }
+
+        addWalks(msg, ticks);
+
+        // rates below one per tick are carried over to the next ticks
+        for(effects += m_effectsPerSecond * tickSeconds; effects >= 1; --effects)
+            addEffect(msg);
+        for(missiles += m_missilesPerSecond * tickSeconds; missiles >= 1; --missiles)
+            addMissile(msg);
+        for(animatedTexts += m_animatedTextsPerSecond * tickSeconds; animatedTexts >= 1; --animatedTexts)
+            addAnimatedText(msg);
+
+        if(msg->getMessageSize() > 0)
+            recorder->addPacket(ticks, msg->getBuffer());
+    }
+
+    m_packetCount = recorder->getPacketCount();
+    recorder->close();
+}
+
+void PacketGenerator::validate()
+{
+    if(!g_things.isDatLoaded())
+        stdext::throw_exception("unable to generate packets, dat is not loaded");
+
+    if(g_game.getClientVersion() == 0)
+        stdext::throw_exception("unable to generate packets, client version is not set");
+
+    if(m_center.z != SEA_FLOOR)
+        stdext::throw_exception(stdext::format("generated sessions must be centered on floor %d", SEA_FLOOR));
+
+    if(!g_things.isValidDatId(m_groundId, ThingCategoryItem))
+        stdext::throw_exception(stdext::format("invalid ground id %d", m_groundId));
+
+    if(!g_things.isValidDatId(m_lookType, ThingCategoryCreature))
+        stdext::throw_exception(stdext::format("invalid look type %d", m_lookType));
+
+    if(m_effectsPerSecond > 0 && !g_things.isValidDatId(m_effectId, ThingCategoryEffect))
+        stdext::throw_exception(stdext::format("invalid effect id %d", m_effectId));
+
+    if(m_missilesPerSecond > 0 && !g_things.isValidDatId(m_missileId, ThingCategoryMissile))
+        stdext::throw_exception(stdext::format("invalid missile id %d", m_missileId));
+}
+
+void PacketGenerator::createCreatures()
+{
+    m_player = { PLAYER_ID, m_center, 0, false };
+
+    m_creatures.clear();
+    m_creatures.reserve(m_creatureCount);
+    for(int i = 0; i < m_creatureCount; ++i) {
+        const uint32 nextWalk = m_random() % m_walkInterval;
+        m_creatures.push_back({ CREATURE_ID_BASE + i, randomPosition(SEA_FLOOR), nextWalk, false });
+    }
+}
+
+void PacketGenerator::addLogin(const OutputMessagePtr& msg)
+{
+    msg->addU8(Proto::GameServerLoginSuccess);
+    msg->addU32(m_player.id);
+    msg->addU16(50); // server beat
+    addDouble(msg, 857.36); // speed formula
+    addDouble(msg, 261.29);
+    addDouble(msg, -4795.01);
+    msg->addU8(0); // can report bugs
+    msg->addU8(0); // can change pvp frame
+    msg->addU8(0); // expert pvp mode
+    msg->addString(std::string()); // store images url
+    msg->addU16(25); // store coin package size
+    msg->addU8(0); // exiva button
+    msg->addU8(0); // tournament button
+
+    msg->addU8(Proto::GameServerEnterGame);
+
+    AwareRange range = g_map.getAwareRange();
+    m_centralPosition = m_center;
+
+    msg->addU8(Proto::GameServerFullMap);
+    addPosition(msg, m_centralPosition);
+    addMapDescription(msg, m_centralPosition.x - range.left, m_centralPosition.y - range.top, m_centralPosition.z, range.horizontal(), range.vertical());
+}
+
+void PacketGenerator::addWalks(const OutputMessagePtr& msg, uint32 ticks)
+{
+    for(auto& creature : m_creatures) {
+        if(creature.nextWalk > ticks)
+            continue;
+
+        creature.nextWalk += m_walkInterval;
+
+        const int first = m_random() % 4;
+        for(int i = 0; i < 4; ++i) {
+            const auto direction = static_cast<Otc::Direction_t>((first + i) % 4);
+            const Position pos = creature.position.translatedToDirection(direction);
+            if(!isWalkable(pos))
+                continue;
+
+            msg->addU8(Proto::GameServerMoveCreature);
+            msg->addU16(0xFFFF);
+            msg->addU32(creature.id);
+            addPosition(msg, pos);
+
+            creature.position = pos;
+            break;
+        }
+    }
+}
+
+void PacketGenerator::addEffect(const OutputMessagePtr& msg)
+{
+    msg->addU8(Proto::GameServerGraphicalEffect);
+    addPosition(msg, randomPosition(m_player.position.z));
+    msg->addU8(Otc::MAGIC_EFFECTS_CREATE_EFFECT);
+    msg->addU8(m_effectId);
+    msg->addU8(Otc::MAGIC_EFFECTS_END_LOOP);
+}
+
+void PacketGenerator::addMissile(const OutputMessagePtr& msg)
+{
+    msg->addU8(Proto::GameServerMissleEffect);
+    addPosition(msg, randomPosition(m_player.position.z));
+    addPosition(msg, randomPosition(m_player.position.z));
+    msg->addU8(m_missileId);
+}
+
+void PacketGenerator::addAnimatedText(const OutputMessagePtr& msg)
+{
+    msg->addU8(Proto::GameServerTextEffect);
+    addPosition(msg, randomPosition(m_player.position.z));
+    msg->addU8(m_random() % 216); // 8 bit color
+    msg->addString(std::to_string(1 + m_random() % 999));
+}
+
+// the player goes down to the underground floor below the center and back up, with the
+// same sequence of messages the server sends when using a ladder or a hole
+void PacketGenerator::addFloorChange(const OutputMessagePtr& msg)
+{
+    AwareRange range = g_map.getAwareRange();
+    const bool sendPosition = g_game.getFeature(Otc::GameMapMovePosition);
+
+    Position pos = m_centralPosition;
+    int skip = -1;
+
+    if(m_player.position.z == SEA_FLOOR) {
+        msg->addU8(Proto::GameServerDeleteOnMap);
+        msg->addU16(0xFFFF);
+        msg->addU32(m_player.id);
+
+        m_player.position.z = UNDERGROUND_FLOOR;
+
+        msg->addU8(Proto::GameServerFloorChangeDown);
+        if(sendPosition)
+            addPosition(msg, m_centralPosition);
+
+        ++pos.z;
+        for(int z = pos.z, offset = -1; z <= pos.z + AWARE_UNDEGROUND_FLOOR_RANGE; ++z, --offset)
+            skip = addFloorDescription(msg, pos.x - range.left, pos.y - range.top, z, range.horizontal(), range.vertical(), offset, skip);
+        addSkip(msg, skip);
+
+        --pos.x;
+        --pos.y;
+        m_centralPosition = pos;
+
+        msg->addU8(Proto::GameServerMapRightRow);
+        if(sendPosition)
+            addPosition(msg, m_centralPosition);
+        ++m_centralPosition.x;
+        addMapDescription(msg, m_centralPosition.x + range.right, m_centralPosition.y - range.top, m_centralPosition.z, 1, range.vertical());
+
+        msg->addU8(Proto::GameServerMapBottomRow);
+        if(sendPosition)
+            addPosition(msg, m_centralPosition);
+        ++m_centralPosition.y;
+        addMapDescription(msg, m_centralPosition.x - range.left, m_centralPosition.y + range.bottom, m_centralPosition.z, range.horizontal(), 1);
+    } else {
+        m_player.position.z = SEA_FLOOR;
+
+        msg->addU8(Proto::GameServerMoveCreature);
+        msg->addU16(0xFFFF);
+        msg->addU32(m_player.id);
+        addPosition(msg, m_player.position);
+
+        msg->addU8(Proto::GameServerFloorChangeUp);
+        if(sendPosition)
+            addPosition(msg, m_centralPosition);
+
+        --pos.z;
+        for(int z = SEA_FLOOR - AWARE_UNDEGROUND_FLOOR_RANGE; z >= 0; --z)
+            skip = addFloorDescription(msg, pos.x - range.left, pos.y - range.top, z, range.horizontal(), range.vertical(), 8 - z, skip);
+        addSkip(msg, skip);
+
+        ++pos.x;
+        ++pos.y;
+        m_centralPosition = pos;
+
+        msg->addU8(Proto::GameServerMapLeftRow);
+        if(sendPosition)
+            addPosition(msg, m_centralPosition);
+        --m_centralPosition.x;
+        addMapDescription(msg, m_centralPosition.x - range.left, m_centralPosition.y - range.top, m_centralPosition.z, 1, range.vertical());
+
+        msg->addU8(Proto::GameServerMapTopRow);
+        if(sendPosition)
+            addPosition(msg, m_centralPosition);
+        --m_centralPosition.y;
+        addMapDescription(msg, m_centralPosition.x - range.left, m_centralPosition.y - range.top, m_centralPosition.z, range.horizontal(), 1);
+    }
+}
+
+// mirrors ProtocolGame::setMapDescription
+void PacketGenerator::addMapDescription(const OutputMessagePtr& msg, int x, int y, int z, int width, int height)
+{
+    int startz, endz, zstep;
+
+    if(z > SEA_FLOOR) {
+        startz = z - AWARE_UNDEGROUND_FLOOR_RANGE;
+        endz = std::min<int>(z + AWARE_UNDEGROUND_FLOOR_RANGE, MAX_Z);
+        zstep = 1;
+    } else {
+        startz = SEA_FLOOR;
+        endz = 0;
+        zstep = -1;
+    }
+
+    int skip = -1;
+    for(int nz = startz; nz != endz + zstep; nz += zstep)
+        skip = addFloorDescription(msg, x, y, nz, width, height, z - nz, skip);
+    addSkip(msg, skip);
+}
+
+// empty tiles are run length encoded, a skip of -1 means there is no tile to terminate yet
+int PacketGenerator::addFloorDescription(const OutputMessagePtr& msg, int x, int y, int z, int width, int height, int offset, int skip)
+{
+    for(int nx = 0; nx < width; ++nx) {
+        for(int ny = 0; ny < height; ++ny) {
+            const Position tilePos(x + nx + offset, y + ny + offset, z);
+
+            const bool hasGround = z == SEA_FLOOR || z == UNDERGROUND_FLOOR;
+            const bool hasPlayer = m_player.position == tilePos;
+            const bool hasCreatures = z == SEA_FLOOR && std::any_of(m_creatures.begin(), m_creatures.end(),
+                                                                    [&](const GeneratedCreature& creature) { return creature.position == tilePos; });
+
+            if(!hasGround && !hasPlayer && !hasCreatures) {
+                if(skip == 0xFE) {
+                    msg->addU16(0xFFFF);
+                    skip = -1;
+                } else
+                    ++skip;
+                continue;
+            }
+
+            addSkip(msg, skip);
+            skip = 0;
+
+            if(hasGround)
+                addItem(msg, m_groundId);
+            if(hasPlayer)
+                addCreature(msg, m_player, true);
+            if(hasCreatures) {
+                for(auto& creature : m_creatures) {
+                    if(creature.position == tilePos)
+                        addCreature(msg, creature, false);
+                }
+            }
+        }
+    }
+    return skip;
+}
+
+void PacketGenerator::addSkip(const OutputMessagePtr& msg, int skip)
+{
+    if(skip >= 0)
+        msg->addU16(0xFF00 | skip);
+}
+
+void PacketGenerator::addCreature(const OutputMessagePtr& msg, GeneratedCreature& creature, bool player)
+{
+    const uint8 creatureType = player ? Proto::CREATURETYPE_PLAYER : Proto::CREATURETYPE_MONSTER;
+
+    if(creature.known) {
+        msg->addU16(Proto::OutdatedCreature);
+        msg->addU32(creature.id);
+    } else {
+        msg->addU16(Proto::UnknownCreature);
+        msg->addU32(0); // remove id
+        msg->addU32(creature.id);
+        msg->addU8(creatureType);
+        msg->addString(player ? "Player" : stdext::format("Creature %d", creature.id - CREATURE_ID_BASE));
+    }
+
+    msg->addU8(100); // health percent
+    msg->addU8(Otc::South);
+
+    msg->addU16(m_lookType);
+    msg->addU8(0); // head
+    msg->addU8(0); // body
+    msg->addU8(0); // legs
+    msg->addU8(0); // feet
+    msg->addU8(0); // addons
+    msg->addU16(0); // mount
+
+    msg->addU8(0); // light intensity
+    msg->addU8(0); // light color
+    msg->addU16(CREATURE_SPEED);
+    msg->addU8(0); // icons
+
+    msg->addU8(Otc::SkullNone);
+    msg->addU8(Otc::ShieldNone);
+    if(!creature.known)
+        msg->addU8(Otc::EmblemNone);
+
+    msg->addU8(creatureType);
+    if(player)
+        msg->addU8(0); // vocation
+
+    msg->addU8(0); // speech bubble
+    msg->addU8(0xff); // mark
+    msg->addU8(0); // inspection type
+    msg->addU8(1); // unpassable
+
+    creature.known = true;
+}
+
+void PacketGenerator::addItem(const OutputMessagePtr& msg, uint16 id)
+{
+    msg->addU16(id);
+
+    const ThingTypePtr& thingType = g_things.getThingType(id, ThingCategoryItem);
+    if(thingType->isStackable() || thingType->isSplash() || thingType->isFluidContainer() || thingType->isChargeable())
+        msg->addU8(1);
+}
+
+Position PacketGenerator::randomPosition(uint8 z)
+{
+    AwareRange range = g_map.getAwareRange();
+    const int width = range.left + range.right + 1 - 2 * AREA_INSET;
+    const int height = range.top + range.bottom + 1 - 2 * AREA_INSET;
+
+    return Position(m_center.x - range.left + AREA_INSET + static_cast<int>(m_random() % width),
+                    m_center.y - range.top + AREA_INSET + static_cast<int>(m_random() % height), z);
+}
+
+bool PacketGenerator::isWalkable(const Position& pos)
+{
+    AwareRange range = g_map.getAwareRange();
+
+    return pos.z == SEA_FLOOR &&
+        pos.x >= m_center.x - range.left + AREA_INSET && pos.x <= m_center.x + range.right - AREA_INSET &&
+        pos.y >= m_center.y - range.top + AREA_INSET && pos.y <= m_center.y + range.bottom - AREA_INSET;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PACKETGENERATOR_H
+#define PACKETGENERATOR_H
+
+#include <client/declarations.h>
+#include <client/util/position.h>
+#include <framework/luaengine/luaobject.h>
+
+#include <random>
+
+// writes a synthetic game session in the PacketRecorder format, so the protocol and map
+// hot paths can be replayed at a chosen load without a server or a recorded session
+// @bindclass
+class PacketGenerator : public LuaObject
+{
+public:
+    void generate(const std::string& fileName);
+
+    void setCenter(const Position& center) { m_center = center; }
+    void setCreatureCount(int count) { m_creatureCount = std::max<int>(0, count); }
+    void setWalkInterval(int interval) { m_walkInterval = std::max<int>(1, interval); }
+    void setEffectsPerSecond(float rate) { m_effectsPerSecond = std::max<float>(0, rate); }
+    void setMissilesPerSecond(float rate) { m_missilesPerSecond = std::max<float>(0, rate); }
+    void setAnimatedTextsPerSecond(float rate) { m_animatedTextsPerSecond = std::max<float>(0, rate); }
+    void setFloorChangeInterval(int interval) { m_floorChangeInterval = std::max<int>(0, interval); }
+    void setDuration(int duration) { m_duration = std::max<int>(0, duration); }
+    void setTickInterval(int interval) { m_tickInterval = std::max<int>(1, interval); }
+    void setGroundId(uint16 id) { m_groundId = id; }
+    void setLookType(uint16 lookType) { m_lookType = lookType; }
+    void setEffectId(uint8 id) { m_effectId = id; }
+    void setMissileId(uint8 id) { m_missileId = id; }
+    void setSeed(uint32 seed) { m_seed = seed; }
+
+    Position getCenter() { return m_center; }
+    int getCreatureCount() { return m_creatureCount; }
+    int getWalkInterval() { return m_walkInterval; }
+    float getEffectsPerSecond() { return m_effectsPerSecond; }
+    float getMissilesPerSecond() { return m_missilesPerSecond; }
+    float getAnimatedTextsPerSecond() { return m_animatedTextsPerSecond; }
+    int getFloorChangeInterval() { return m_floorChangeInterval; }
+    int getDuration() { return m_duration; }
+    int getTickInterval() { return m_tickInterval; }
+    uint32 getPacketCount() { return m_packetCount; }
+
+private:
+    struct GeneratedCreature {
+        uint32 id;
+        Position position;
+        uint32 nextWalk;
+        bool known;
+    };
+
+    void validate();
+    void createCreatures();
+
+    void addLogin(const OutputMessagePtr& msg);
+    void addWalks(const OutputMessagePtr& msg, uint32 ticks);
+    void addEffect(const OutputMessagePtr& msg);
+    void addMissile(const OutputMessagePtr& msg);
+    void addAnimatedText(const OutputMessagePtr& msg);
+    void addFloorChange(const OutputMessagePtr& msg);
+
+    void addMapDescription(const OutputMessagePtr& msg, int x, int y, int z, int width, int height);
+    int addFloorDescription(const OutputMessagePtr& msg, int x, int y, int z, int width, int height, int offset, int skip);
+    void addSkip(const OutputMessagePtr& msg, int skip);
+    void addCreature(const OutputMessagePtr& msg, GeneratedCreature& creature, bool player);
+    void addItem(const OutputMessagePtr& msg, uint16 id);
+
+    Position randomPosition(uint8 z);
+    bool isWalkable(const Position& pos);
+
+    Position m_center{ 1000, 1000, 7 };
+    int m_creatureCount{ 100 };
+    int m_walkInterval{ 800 };
+    float m_effectsPerSecond{ 20 };
+    float m_missilesPerSecond{ 10 };
+    float m_animatedTextsPerSecond{ 10 };
+    int m_floorChangeInterval{ 0 };
+    int m_duration{ 60000 };
+    int m_tickInterval{ 50 };
+    uint16 m_groundId{ 4526 };
+    uint16 m_lookType{ 128 };
+    uint8 m_effectId{ 1 };
+    uint8 m_missileId{ 1 };
+    uint32 m_seed{ 0 };
+
+    std::mt19937 m_random;
+    GeneratedCreature m_player;
+    std::vector<GeneratedCreature> m_creatures;
+    Position m_centralPosition;
+    uint32 m_packetCount{ 0 };
+};
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "packetplayer.h"
+#include "packetrecorder.h"
+
+#include <client/game.h>
+#include <client/map/map.h>
+#include <client/protocol/protocolgame.h>
+#include <framework/core/eventdispatcher.h>
+#include <framework/core/filestream.h>
+#include <framework/core/resourcemanager.h>
+
+PacketPlayer::PacketPlayer(const std::string& fileName) : m_fileName(fileName)
+{
+    const FileStreamPtr fin = g_resources.openFile(fileName);
+    fin->cache();
+
+    if(fin->getU32() != OTCR_SIGNATURE)
+        stdext::throw_exception(stdext::format("invalid packet record file '%s'", fileName));
+
+    const uint16 version = fin->getU16();
+    if(version != OTCR_VERSION)
+        stdext::throw_exception(stdext::format("packet record file '%s' has unsupported version %d", fileName, version));
+
+    m_protocolVersion = fin->getU16();
+    m_clientVersion = fin->getU16();
+
+    const uint16 featureCount = fin->getU16();
+    m_features.resize(featureCount);
+    for(int i = 0; i < featureCount; i += 8) {
+        const uint8 bits = fin->getU8();
+        for(int j = 0; j < 8 && i + j < featureCount; ++j)
+            m_features[i + j] = bits & (1 << j);
+    }
+
+    m_awareRange.left = fin->getU8();
+    m_awareRange.top = fin->getU8();
+    m_awareRange.right = fin->getU8();
+    m_awareRange.bottom = fin->getU8();
+
+    while(!fin->eof()) {
+        Packet packet;
+        packet.ticks = fin->getU32();
+        packet.buffer.resize(fin->getU16());
+        if(!packet.buffer.empty())
+            fin->read(&packet.buffer[0], packet.buffer.size());
+        m_packets.push_back(std::move(packet));
+    }
+
+    m_inputMessage = InputMessagePtr(new InputMessage);
+}
+
+PacketPlayer::~PacketPlayer()
+{
+    if(m_playEvent)
+        m_playEvent->cancel();
+}
+
+void PacketPlayer::start(const ProtocolGamePtr& protocol, bool realtime)
+{
+    if(m_protocol)
+        stdext::throw_exception("packet player is already playing");
+
+    applyFeatures();
+
+    m_protocol = protocol;
+    m_realtime = realtime;
+    m_nextPacket = 0;
+    m_startTicks = stdext::millis();
+
+    // when not realtime the caller drives the playback through playNext or playAll
+    if(m_realtime)
+        scheduleNext();
+}
+
+void PacketPlayer::stop()
+{
+    if(m_playEvent) {
+        m_playEvent->cancel();
+        m_playEvent = nullptr;
+    }
+    m_protocol = nullptr;
+}
+
+bool PacketPlayer::playNext()
+{
+    if(!m_protocol || isFinished())
+        return false;
+
+    const Packet& packet = m_packets[m_nextPacket++];
+    m_inputMessage->setBuffer(packet.buffer);
+    m_inputMessage->setReadPos(InputMessage::MAX_HEADER_SIZE);
+
+    stdext::timer parseTimer;
+    m_protocol->parseMessage(m_inputMessage);
+    if(m_onPacket)
+        m_onPacket(packet, parseTimer.elapsed_micros());
+
+    if(isFinished())
+        finish();
+    return true;
+}
+
+void PacketPlayer::playAll()
+{
+    while(playNext());
+}
+
+void PacketPlayer::applyFeatures()
+{
+    g_game.setClientVersion(m_clientVersion);
+    g_game.setProtocolVersion(m_protocolVersion);
+
+    for(uint i = 0; i < m_features.size() && i < Otc::LastGameFeature; ++i)
+        g_game.setFeature(static_cast<Otc::GameFeature_t>(i), m_features[i]);
+
+    g_map.setAwareRange(m_awareRange);
+}
+
+void PacketPlayer::scheduleNext()
+{
+    if(!m_protocol || isFinished())
+        return;
+
+    const ticks_t elapsed = stdext::millis() - m_startTicks;
+    const int delay = std::max<int>(0, m_packets[m_nextPacket].ticks - elapsed);
+    m_playEvent = g_dispatcher.scheduleEvent([self = static_self_cast<PacketPlayer>()] {
+        self->m_playEvent = nullptr;
+
+        // play every packet that is due, the dispatcher is not precise enough for one event per packet
+        const ticks_t elapsed = stdext::millis() - self->m_startTicks;
+        while(self->m_protocol && !self->isFinished() && self->m_packets[self->m_nextPacket].ticks <= elapsed)
+            self->playNext();
+
+        self->scheduleNext();
+    }, delay);
+}
+
+void PacketPlayer::finish()
+{
+    m_protocol = nullptr;
+    callLuaField("onFinish");
+}
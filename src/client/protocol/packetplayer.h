@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PACKETPLAYER_H
+#define PACKETPLAYER_H
+
+#include <client/declarations.h>
+#include <client/map/mapview.h>
+#include <framework/core/declarations.h>
+#include <framework/luaengine/luaobject.h>
+
+// replays a session written by PacketRecorder through ProtocolGame, no server or socket involved
+// @bindclass
+class PacketPlayer : public LuaObject
+{
+public:
+    struct Packet {
+        uint32 ticks;
+        std::string buffer;
+    };
+
+    using OnPacketCallback = std::function<void(const Packet&, ticks_t parseMicros)>;
+
+    PacketPlayer(const std::string& fileName);
+    ~PacketPlayer() override;
+
+    void start(const ProtocolGamePtr& protocol, bool realtime);
+    void stop();
+    bool playNext();
+    void playAll();
+
+    std::string getFileName() { return m_fileName; }
+    int getProtocolVersion() { return m_protocolVersion; }
+    int getClientVersion() { return m_clientVersion; }
+    uint32 getPacketCount() { return m_packets.size(); }
+    uint32 getPlayedCount() { return m_nextPacket; }
+    uint32 getDuration() { return m_packets.empty() ? 0 : m_packets.back().ticks; }
+    bool isRealtime() { return m_realtime; }
+    bool isPlaying() { return m_protocol != nullptr; }
+    bool isFinished() { return m_nextPacket >= m_packets.size(); }
+
+    const std::vector<Packet>& getPackets() { return m_packets; }
+    void setOnPacket(const OnPacketCallback& onPacket) { m_onPacket = onPacket; }
+
+private:
+    void applyFeatures();
+    void scheduleNext();
+    void finish();
+
+    std::string m_fileName;
+    int m_protocolVersion{ 0 };
+    int m_clientVersion{ 0 };
+    std::vector<bool> m_features;
+    AwareRange m_awareRange;
+    std::vector<Packet> m_packets;
+
+    ProtocolGamePtr m_protocol;
+    InputMessagePtr m_inputMessage;
+    ScheduledEventPtr m_playEvent;
+    OnPacketCallback m_onPacket;
+    ticks_t m_startTicks{ 0 };
+    uint32 m_nextPacket{ 0 };
+    bool m_realtime{ false };
+};
+
+#endif
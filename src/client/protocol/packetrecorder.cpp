@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "packetrecorder.h"
+
+#include <client/game.h>
+#include <client/map/map.h>
+#include <framework/core/filestream.h>
+#include <framework/core/resourcemanager.h>
+
+PacketRecorder::PacketRecorder(const std::string& fileName) : m_fileName(fileName)
+{
+    m_file = g_resources.createFile(fileName);
+    m_startTicks = stdext::millis();
+
+    // header
+    m_file->addU32(OTCR_SIGNATURE);
+    m_file->addU16(OTCR_VERSION);
+    m_file->addU16(g_game.getProtocolVersion());
+    m_file->addU16(g_game.getClientVersion());
+
+    // login time feature set, one bit per feature
+    m_file->addU16(Otc::LastGameFeature);
+    for(int i = 0; i < Otc::LastGameFeature; i += 8) {
+        uint8 bits = 0;
+        for(int j = 0; j < 8 && i + j < Otc::LastGameFeature; ++j) {
+            if(g_game.getFeature(static_cast<Otc::GameFeature_t>(i + j)))
+                bits |= 1 << j;
+        }
+        m_file->addU8(bits);
+    }
+
+    // map descriptions are sized by the aware range, so it has to match at replay
+    const AwareRange range = g_map.getAwareRange();
+    m_file->addU8(range.left);
+    m_file->addU8(range.top);
+    m_file->addU8(range.right);
+    m_file->addU8(range.bottom);
+}
+
+PacketRecorder::~PacketRecorder()
+{
+    close();
+}
+
+void PacketRecorder::addInputPacket(const InputMessagePtr& msg)
+{
+    if(!m_file)
+        return;
+
+    // only the unread part, the packet size and encryption headers are already consumed
+    addPacket(static_cast<uint32>(stdext::millis() - m_startTicks), msg->getBuffer().substr(msg->getReadSize()));
+}
+
+void PacketRecorder::addPacket(uint32 ticks, const std::string& buffer)
+{
+    if(!m_file)
+        return;
+
+    m_file->addU32(ticks);
+    m_file->addU16(buffer.size());
+    m_file->write(buffer.data(), buffer.size());
+    ++m_packetCount;
+}
+
+void PacketRecorder::close()
+{
+    if(!m_file)
+        return;
+
+    m_file->flush();
+    m_file->close();
+    m_file = nullptr;
+}
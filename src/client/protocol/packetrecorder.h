@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PACKETRECORDER_H
+#define PACKETRECORDER_H
+
+#include <client/declarations.h>
+#include <framework/core/declarations.h>
+#include <framework/luaengine/luaobject.h>
+
+enum {
+    OTCR_SIGNATURE = 0x5243544F,
+    OTCR_VERSION = 2
+};
+
+// records every decrypted game packet, so a session can be replayed offline by PacketPlayer
+// @bindclass
+class PacketRecorder : public LuaObject
+{
+public:
+    PacketRecorder(const std::string& fileName);
+    ~PacketRecorder() override;
+
+    void addInputPacket(const InputMessagePtr& msg);
+    void addPacket(uint32 ticks, const std::string& buffer);
+    void close();
+
+    std::string getFileName() { return m_fileName; }
+    uint32 getPacketCount() { return m_packetCount; }
+    bool isRecording() { return m_file != nullptr; }
+
+private:
+    std::string m_fileName;
+    FileStreamPtr m_file;
+    ticks_t m_startTicks;
+    uint32 m_packetCount{ 0 };
+};
+
+#endif
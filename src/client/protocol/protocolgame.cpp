@@ -25,6 +25,8 @@
 #include <client/thing/item.h>
 #include <client/thing/creature/localplayer.h>
 #include <client/thing/creature/player.h>
+#include <client/protocol/packetplayer.h>
+#include <client/protocol/packetrecorder.h>
 
 void ProtocolGame::login(const std::string& accountName, const std::string& accountPassword, const std::string& host, uint16 port, const std::string& characterName, const std::string& authenticatorToken, const std::string& sessionKey)
 {
@@ -60,10 +62,24 @@ void ProtocolGame::onRecv(const InputMessagePtr& inputMessage)
         }
     }
 
+    if(m_recorder)
+        m_recorder->addInputPacket(inputMessage);
+
     parseMessage(inputMessage);
     recv();
 }
 
+void ProtocolGame::playRecord(const PacketPlayerPtr& player, bool realtime)
+{
+    if(m_player)
+        m_player->stop();
+
+    m_firstRecv = false;
+    m_localPlayer = g_game.getLocalPlayer();
+    m_player = player;
+    m_player->start(static_self_cast<ProtocolGame>(), realtime);
+}
+
 void ProtocolGame::onError(const boost::system::error_code& error)
 {
     g_game.processConnectionError(error);
@@ -28,6 +28,29 @@
 #include <framework/net/protocol.h>
 #include <client/thing/creature/creature.h>
 
+#ifdef BENCHMARK
+// hot path costs collected only by the otclient_bench target
+struct ProtocolBenchmarkCounter {
+    uint64 calls{ 0 };
+    uint64 nanos{ 0 };
+};
+
+class ProtocolBenchmarkScope
+{
+public:
+    ProtocolBenchmarkScope(ProtocolBenchmarkCounter& counter) : m_counter(counter), m_start(std::chrono::steady_clock::now()) {}
+    ~ProtocolBenchmarkScope()
+    {
+        ++m_counter.calls;
+        m_counter.nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+private:
+    ProtocolBenchmarkCounter& m_counter;
+    std::chrono::steady_clock::time_point m_start;
+};
+#endif
+
 class ProtocolGame : public Protocol
 {
 public:
@@ -123,12 +146,25 @@ public:
     // otclient only
     void sendChangeMapAwareRange(int xrange, int yrange);
 
+    // session recording and offline replay
+    void setRecorder(const PacketRecorderPtr& recorder) { m_recorder = recorder; }
+    PacketRecorderPtr getRecorder() { return m_recorder; }
+    void playRecord(const PacketPlayerPtr& player, bool realtime);
+    PacketPlayerPtr getPlayer() { return m_player; }
+
+#ifdef BENCHMARK
+    static ProtocolBenchmarkCounter tileDescriptionCounter;
+    static ProtocolBenchmarkCounter creatureMoveCounter;
+#endif
+
 protected:
     void onConnect() override;
     void onRecv(const InputMessagePtr& inputMessage) override;
     void onError(const boost::system::error_code& error) override;
+    virtual void parseMessage(const InputMessagePtr& msg);
 
     friend class Game;
+    friend class PacketPlayer;
 
 public:
     void addPosition(const OutputMessagePtr& msg, const Position& position);
@@ -151,7 +187,6 @@ private:
     void parseRefreshBestiaryTracker(const InputMessagePtr& msg);
     void parsePreset(const InputMessagePtr& msg);
     void parseCreatureType(const InputMessagePtr& msg);
-    void parseMessage(const InputMessagePtr& msg);
     void parsePendingGame(const InputMessagePtr& msg);
     void parseEnterGame(const InputMessagePtr& msg);
     void parseLogin(const InputMessagePtr& msg);
@@ -300,6 +335,8 @@ private:
     std::string m_sessionKey;
     std::string m_characterName;
     LocalPlayerPtr m_localPlayer;
+    PacketRecorderPtr m_recorder;
+    PacketPlayerPtr m_player;
 };
 
 #endif
@@ -32,21 +32,39 @@
 #include <client/map/tile.h>
 #include <client/lua/luavaluecasts.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/core/profiler.h>
+
+#ifdef BENCHMARK
+ProtocolBenchmarkCounter ProtocolGame::tileDescriptionCounter;
+ProtocolBenchmarkCounter ProtocolGame::creatureMoveCounter;
+#endif
 
 void ProtocolGame::parseMessage(const InputMessagePtr& msg)
 {
+    PROFILE_SCOPE("protocol parse");
     int16 opcode = -1;
     int16 prevOpcode = -1;
 
+    ProtocolStats& stats = g_game.getProtocolStats();
+    const bool statsEnabled = stats.isEnabled();
+    if(statsEnabled)
+        stats.beginPacket(msg->getUnreadSize());
+
     try
     {
         while(!msg->eof())
         {
+            const int opcodePos = msg->getReadPos();
+            const ticks_t opcodeStart = statsEnabled ? stdext::micros() : 0;
+
             opcode = msg->getU8();
 
             // try to parse in lua first
             const int readPos = msg->getReadPos();
-            if(callLuaField<bool>("onOpcode", opcode, msg)) {
+            static const LuaFieldKey field("onOpcode");
+            if(callLuaField<bool>(field, opcode, msg)) {
+                if(statsEnabled)
+                    stats.addOpcode(opcode, msg->getReadPos() - opcodePos, stdext::micros() - opcodeStart);
                 continue;
             }
 
@@ -474,12 +492,18 @@ void ProtocolGame::parseMessage(const InputMessagePtr& msg)
                 break;
             }
             prevOpcode = opcode;
+
+            if(statsEnabled)
+                stats.addOpcode(opcode, msg->getReadPos() - opcodePos, stdext::micros() - opcodeStart);
         }
     } catch(stdext::exception& e)
     {
         g_logger.error(stdext::format("ProtocolGame parse message exception (%d bytes unread, last opcode is 0x%02x (%d), prev opcode is 0x%02x(%d)): %s",
                                       msg->getUnreadSize(), opcode, opcode, prevOpcode, prevOpcode, e.what()));
     }
+
+    if(statsEnabled)
+        stats.endPacket();
 }
 
 void ProtocolGame::parseLogin(const InputMessagePtr& msg)
@@ -944,6 +968,9 @@ void ProtocolGame::parseTileRemoveThing(const InputMessagePtr& msg)
 
 void ProtocolGame::parseCreatureMove(const InputMessagePtr& msg)
 {
+#ifdef BENCHMARK
+    ProtocolBenchmarkScope benchmarkScope(creatureMoveCounter);
+#endif
     const auto& thing = getMappedThing(msg);
     const Position& newPos = getPosition(msg);
 
@@ -2127,6 +2154,9 @@ int ProtocolGame::setFloorDescription(const InputMessagePtr& msg, int x, int y,
 
 int ProtocolGame::setTileDescription(const InputMessagePtr& msg, const Position& position)
 {
+#ifdef BENCHMARK
+    ProtocolBenchmarkScope benchmarkScope(tileDescriptionCounter);
+#endif
     g_map.cleanTile(position);
 
     if(msg->peekU16() >= 0xff00)
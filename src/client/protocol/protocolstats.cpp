@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "protocolstats.h"
+
+#include <framework/luaengine/luainterface.h>
+
+void LatencyHistogram::add(uint32 value)
+{
+    ++m_counts[bucketIndex(value)];
+    ++m_total;
+}
+
+uint32 LatencyHistogram::getPercentile(double percentile) const
+{
+    if(m_total == 0)
+        return 0;
+
+    const uint64 target = std::max<uint64>(1, std::ceil(m_total * percentile / 100.0));
+    uint64 count = 0;
+    for(int i = 0; i < BUCKET_COUNT; ++i) {
+        count += m_counts[i];
+        if(count >= target)
+            return bucketValue(i);
+    }
+    return bucketValue(BUCKET_COUNT - 1);
+}
+
+int LatencyHistogram::bucketIndex(uint32 value)
+{
+    value = std::min<uint32>(value, (1 << MAX_VALUE_BITS) - 1);
+    if(value < SUB_BUCKET_COUNT)
+        return value;
+
+    int msb = SUB_BUCKET_BITS;
+    while(value >> (msb + 1))
+        ++msb;
+
+    const int shift = msb - SUB_BUCKET_BITS;
+    return SUB_BUCKET_COUNT * (shift + 1) + (value >> shift) - SUB_BUCKET_COUNT;
+}
+
+// the highest value that falls in the bucket
+uint32 LatencyHistogram::bucketValue(int index)
+{
+    if(index < SUB_BUCKET_COUNT)
+        return index;
+
+    const int shift = index / SUB_BUCKET_COUNT - 1;
+    const int subBucket = index % SUB_BUCKET_COUNT;
+    return ((SUB_BUCKET_COUNT + subBucket + 1) << shift) - 1;
+}
+
+void ProtocolStats::beginPacket(uint32 size)
+{
+    m_packetOpcodes.clear();
+    m_packetSize = size;
+    m_packetStart = stdext::micros();
+}
+
+void ProtocolStats::addOpcode(uint8 opcode, uint32 bytes, ticks_t micros)
+{
+    auto& stats = m_opcodes[opcode];
+    if(!stats)
+        stats = std::make_unique<OpcodeStats>();
+
+    ++stats->count;
+    stats->bytes += bytes;
+    stats->totalMicros += micros;
+    stats->maxMicros = std::max<uint32>(stats->maxMicros, micros);
+    stats->histogram.add(micros);
+
+    m_packetOpcodes.push_back(opcode);
+}
+
+void ProtocolStats::endPacket()
+{
+    const ticks_t micros = stdext::micros() - m_packetStart;
+
+    ++m_packetCount;
+    m_byteCount += m_packetSize;
+
+    if(m_slowPacketThreshold <= 0 || micros < m_slowPacketThreshold)
+        return;
+
+    SlowPacket packet;
+    packet.time = stdext::millis();
+    packet.micros = micros;
+    packet.size = m_packetSize;
+    packet.opcodes = m_packetOpcodes;
+
+    if(m_slowPackets.size() >= SLOW_PACKET_HISTORY)
+        m_slowPackets.pop_front();
+    m_slowPackets.push_back(packet);
+
+    g_lua.callGlobalField("g_game", "onSlowPacket", packet.micros, packet.size, packet.opcodes);
+}
+
+void ProtocolStats::reset()
+{
+    for(auto& stats : m_opcodes)
+        stats.reset();
+    m_slowPackets.clear();
+    m_packetCount = 0;
+    m_byteCount = 0;
+}
+
+std::map<int, ProtocolOpcodeSummary> ProtocolStats::getOpcodeSummaries()
+{
+    std::map<int, ProtocolOpcodeSummary> summaries;
+    for(int opcode = 0; opcode < static_cast<int>(m_opcodes.size()); ++opcode) {
+        const auto& stats = m_opcodes[opcode];
+        if(!stats)
+            continue;
+
+        ProtocolOpcodeSummary& summary = summaries[opcode];
+        summary.opcode = opcode;
+        summary.count = stats->count;
+        summary.bytes = stats->bytes;
+        summary.totalMicros = stats->totalMicros;
+        summary.maxMicros = stats->maxMicros;
+        summary.p50 = stats->histogram.getPercentile(50);
+        summary.p90 = stats->histogram.getPercentile(90);
+        summary.p99 = stats->histogram.getPercentile(99);
+    }
+    return summaries;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PROTOCOLSTATS_H
+#define PROTOCOLSTATS_H
+
+#include <client/global.h>
+
+// log-linear latency histogram in the spirit of HDR histograms, every power of two
+// is split in 16 buckets, so a percentile is never more than 1/16 off
+class LatencyHistogram
+{
+public:
+    enum {
+        SUB_BUCKET_BITS = 4,
+        SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS,
+        MAX_VALUE_BITS = 24,
+        BUCKET_COUNT = SUB_BUCKET_COUNT * (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1)
+    };
+
+    void add(uint32 value);
+    uint32 getPercentile(double percentile) const;
+
+private:
+    static int bucketIndex(uint32 value);
+    static uint32 bucketValue(int index);
+
+    std::array<uint32, BUCKET_COUNT> m_counts{};
+    uint64 m_total{ 0 };
+};
+
+struct ProtocolOpcodeSummary {
+    uint8 opcode;
+    uint64 count;
+    uint64 bytes;
+    uint64 totalMicros;
+    uint32 maxMicros;
+    uint32 p50, p90, p99;
+};
+
+struct SlowPacket {
+    ticks_t time;
+    ticks_t micros;
+    uint32 size;
+    std::vector<uint8> opcodes;
+};
+
+// per opcode counts, bytes and parse times of the game protocol, fed by ProtocolGame::parseMessage
+class ProtocolStats
+{
+public:
+    enum {
+        SLOW_PACKET_HISTORY = 32
+    };
+
+    void beginPacket(uint32 size);
+    void addOpcode(uint8 opcode, uint32 bytes, ticks_t micros);
+    void endPacket();
+    void reset();
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    void setSlowPacketThreshold(int micros) { m_slowPacketThreshold = micros; }
+
+    bool isEnabled() { return m_enabled; }
+    int getSlowPacketThreshold() { return m_slowPacketThreshold; }
+    uint64 getPacketCount() { return m_packetCount; }
+    uint64 getByteCount() { return m_byteCount; }
+
+    std::map<int, ProtocolOpcodeSummary> getOpcodeSummaries();
+    std::deque<SlowPacket> getSlowPackets() { return m_slowPackets; }
+
+private:
+    struct OpcodeStats {
+        uint64 count{ 0 };
+        uint64 bytes{ 0 };
+        uint64 totalMicros{ 0 };
+        uint32 maxMicros{ 0 };
+        LatencyHistogram histogram;
+    };
+
+    // allocated on first use, a session only sees a fraction of the opcodes
+    std::array<std::unique_ptr<OpcodeStats>, 256> m_opcodes;
+    std::vector<uint8> m_packetOpcodes;
+    std::deque<SlowPacket> m_slowPackets;
+
+    ticks_t m_packetStart{ 0 };
+    uint32 m_packetSize{ 0 };
+    uint64 m_packetCount{ 0 };
+    uint64 m_byteCount{ 0 };
+    int m_slowPacketThreshold{ 10000 };
+    bool m_enabled{ true };
+};
+
+#endif
@@ -28,6 +28,7 @@
 #include <client/thing/creature/localplayer.h>
 #include <client/lua/luavaluecasts.h>
 #include <client/map/map.h>
+#include <client/manager/walkmanager.h>
 #include <client/manager/thingtypemanager.h>
 #include <client/map/tile.h>
 
@@ -108,12 +109,7 @@ void Creature::walk(const Position& oldPos, const Position& newPos)
     // no direction need to be changed when the walk ends
     m_walkTurnDirection = Otc::InvalidDirection;
 
-    if(m_walkFinishAnimEvent) {
-        m_walkFinishAnimEvent->cancel();
-        m_walkFinishAnimEvent = nullptr;
-    }
-
-    // starts updating walk
+    // starts updating walk, also cancels any pending animation reset
     nextWalkUpdate();
 }
 
@@ -186,7 +182,8 @@ void Creature::updateJump()
 
 void Creature::onPositionChange(const Position& newPos, const Position& oldPos)
 {
-    callLuaField("onPositionChange", newPos, oldPos);
+    static const LuaFieldKey field("onPositionChange");
+    callLuaField(field, newPos, oldPos);
 }
 
 void Creature::onAppear()
@@ -206,7 +203,8 @@ void Creature::onAppear()
     else if(m_oldPosition != m_position && m_oldPosition.isInRange(m_position, 1, 1) && m_allowAppearWalk) {
         m_allowAppearWalk = false;
         walk(m_oldPosition, m_position);
-        callLuaField("onWalk", m_oldPosition, m_position);
+        static const LuaFieldKey field("onWalk");
+        callLuaField(field, m_oldPosition, m_position);
     } // teleport
     else if(m_oldPosition != m_position) {
         stopWalk();
@@ -320,8 +318,7 @@ void Creature::updateWalkingTile()
 void Creature::nextWalkUpdate()
 {
     // remove any previous scheduled walk updates
-    if(m_walkUpdateEvent)
-        m_walkUpdateEvent->cancel();
+    g_walks.cancel(this);
 
     // do the update
     updateWalk();
@@ -329,11 +326,7 @@ void Creature::nextWalkUpdate()
     if(!m_walking) return;
 
     // schedules next update
-    auto self = static_self_cast<Creature>();
-    m_walkUpdateEvent = g_dispatcher.scheduleEvent([self] {
-        self->m_walkUpdateEvent = nullptr;
-        self->nextWalkUpdate();
-    }, std::max<int>(m_stepCache.duration / SPRITE_SIZE, 16));
+    g_walks.scheduleUpdate(static_self_cast<Creature>(), std::max<int>(m_stepCache.duration / SPRITE_SIZE, 16));
 }
 
 void Creature::updateWalk()
@@ -362,12 +355,6 @@ void Creature::updateWalk()
 
 void Creature::terminateWalk()
 {
-    // remove any scheduled walk update
-    if(m_walkUpdateEvent) {
-        m_walkUpdateEvent->cancel();
-        m_walkUpdateEvent = nullptr;
-    }
-
     // now the walk has ended, do any scheduled turn
     if(m_walkTurnDirection != Otc::InvalidDirection) {
         setDirection(m_walkTurnDirection);
@@ -383,12 +370,8 @@ void Creature::terminateWalk()
     m_walkOffset = Point();
     m_walkedPixels = 0;
 
-    const auto self = static_self_cast<Creature>();
-    m_walkFinishAnimEvent = g_dispatcher.scheduleEvent([self] {
-        self->m_totalWalkedPixels = 0;
-        self->m_walkAnimationPhase = 0;
-        self->m_walkFinishAnimEvent = nullptr;
-    }, 50);
+    // replaces any scheduled walk update
+    g_walks.scheduleFinish(static_self_cast<Creature>(), 50);
 }
 
 void Creature::setName(const std::string& name)
@@ -416,7 +399,8 @@ void Creature::setHealthPercent(uint8 healthPercent)
 
     const uint8 oldHealthPercent = m_healthPercent;
     m_healthPercent = healthPercent;
-    callLuaField("onHealthPercentChange", healthPercent, oldHealthPercent);
+    static const LuaFieldKey field("onHealthPercentChange");
+    callLuaField(field, healthPercent, oldHealthPercent);
 
     if(isDead()) onDeath();
 }
@@ -199,8 +199,7 @@ protected:
     Timer m_walkTimer;
     Timer m_footTimer;
     TilePtr m_walkingTile;
-    ScheduledEventPtr m_walkUpdateEvent;
-    ScheduledEventPtr m_walkFinishAnimEvent;
+    int m_walkSlot{ -1 };
     EventPtr m_disappearEvent;
     Point m_walkOffset;
     Otc::Direction_t m_walkTurnDirection;
@@ -216,6 +215,7 @@ protected:
     Timer m_jumpTimer;
 
     friend class CreaturePainter;
+    friend class WalkManager;
 
 private:
     struct DrawCache {
@@ -98,7 +98,7 @@ public:
     std::string getName();
     bool isValid();
 
-    void unserializeItem(const BinaryTreePtr& in);
+    void unserializeItem(BinaryTreeNode& in);
     void serializeItem(const OutputBinaryTreePtr& out);
 
     void setDepotId(uint16 depotId) { m_attribs.set(ATTR_DEPOT_ID, depotId); }
@@ -27,47 +27,37 @@
 #include <framework/core/binarytree.h>
 #include <framework/core/filestream.h>
 
-void ItemType::unserialize(const BinaryTreePtr& node)
+void ItemType::unserialize(BinaryTreeNode& node)
 {
     m_null = false;
 
-    m_category = static_cast<ItemCategory>(node->getU8());
+    m_category = static_cast<ItemCategory>(node.getU8());
 
-    node->getU32(); // flags
+    node.getU32(); // flags
 
-    static uint16 lastId = 99;
-    while(node->canRead()) {
-        const uint8 attr = node->getU8();
+    while(node.canRead()) {
+        const uint8 attr = node.getU8();
         if(attr == 0 || attr == 0xFF)
             break;
 
-        const uint16 len = node->getU16();
+        const uint16 len = node.getU16();
         switch(attr) {
         case ItemTypeAttrServerId:
         {
-            uint16 serverId = node->getU16();
-
-            if(serverId > 30000 && serverId < 30100) {
+            uint16 serverId = node.getU16();
+            if(serverId > 30000 && serverId < 30100)
                 serverId -= 30000;
-            } else if(lastId > 99 && lastId != serverId - 1) {
-                while(lastId != serverId - 1) {
-                    ItemTypePtr tmp(new ItemType);
-                    tmp->setServerId(++lastId);
-                    g_things.addItemType(tmp);
-                }
-            }
 
             setServerId(serverId);
-            lastId = serverId;
             break;
         }
 
         case ItemTypeAttrClientId:
-            setClientId(node->getU16());
+            setClientId(node.getU16());
             break;
 
         case ItemTypeAttrName:
-            setName(node->getString(len));
+            setName(node.getString(len));
             break;
 
         case ItemTypeAttrWritable:
@@ -75,7 +65,7 @@ void ItemType::unserialize(const BinaryTreePtr& node)
             break;
 
         default:
-            node->skip(len); // skip attribute
+            node.skip(len); // skip attribute
             break;
         }
     }
@@ -83,7 +83,7 @@ enum ItemTypeAttr : uint8 {
 class ItemType : public LuaObject
 {
 public:
-    void unserialize(const BinaryTreePtr& node);
+    void unserialize(BinaryTreeNode& node);
 
     void setServerId(uint16 serverId) { m_attribs.set(ItemTypeAttrServerId, serverId); }
     uint16 getServerId() { return m_attribs.get<uint16>(ItemTypeAttrServerId); }
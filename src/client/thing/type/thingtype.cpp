@@ -143,7 +143,7 @@ void ThingType::unserialize(uint16 clientId, ThingCategory category, const FileS
         if(attr == 16)
             attr = ThingAttrNoMoveAnimation;
         else if(attr == 254) { // Usable
-            m_attribs.set(ThingAttrUsable, true);
+            m_attribs.set(ThingAttrUsable, static_cast<uint16>(0));
             continue;
         } else if(attr == 35) { // Default Action
             m_attribs.set(ThingAttrDefaultAction, fin->getU16());
@@ -181,8 +181,9 @@ void ThingType::unserialize(uint16 clientId, ThingCategory category, const FileS
         }
         case ThingAttrElevation:
         {
-            m_elevation = fin->getU16();
-            m_attribs.set(attr, m_elevation);
+            const uint16 elevation = fin->getU16();
+            m_elevation = elevation;
+            m_attribs.set(attr, elevation);
             break;
         }
         case ThingAttrUsable:
@@ -293,6 +294,11 @@ void ThingType::unserialize(uint16 clientId, ThingCategory category, const FileS
         }
     }
 
+    resetTextures();
+}
+
+void ThingType::resetTextures()
+{
     m_textures.resize(m_animationPhases);
     m_blankTextures.resize(m_animationPhases);
     m_texturesFramesRects.resize(m_animationPhases);
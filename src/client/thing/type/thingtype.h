@@ -225,11 +225,13 @@ public:
     const TexturePtr& getTexture(int animationPhase, bool allBlank = false);
 
     friend class ThingPainter;
+    friend class ThingTypeCache;
 
 private:
     static Size getBestTextureDimension(int w, int h, int count);
 
     bool hasTexture() const { return !m_textures.empty(); }
+    void resetTextures();
 
     uint getSpriteIndex(int w, int h, int l, int x, int y, int z, int a);
     uint getTextureIndex(int l, int x, int y, int z);
@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "thingtypecache.h"
+
+#include <client/util/animator.h>
+#include <framework/core/resourcemanager.h>
+
+namespace {
+    // attributes unserialized with an uint16 value, any other is a flag
+    bool hasAttrValue(int attr)
+    {
+        switch(attr) {
+        case ThingAttrUsable:
+        case ThingAttrDefaultAction:
+        case ThingAttrElevation:
+        case ThingAttrGround:
+        case ThingAttrWritable:
+        case ThingAttrWritableOnce:
+        case ThingAttrMinimapColor:
+        case ThingAttrCloth:
+        case ThingAttrLensHelp:
+            return true;
+        default:
+            return false;
+        }
+    }
+}
+
+template<typename T>
+const T* ThingTypeCache::section(uint32 offset, uint32 count)
+{
+    if(offset + static_cast<uint64>(count) * sizeof(T) > m_data.size())
+        stdext::throw_exception("corrupt dat cache");
+    return reinterpret_cast<const T*>(m_data.data() + offset);
+}
+
+bool ThingTypeCache::load(const std::string& fileName, const Key& key)
+{
+    if(!g_resources.fileExists(fileName))
+        return false;
+
+    m_data = g_resources.readFileContents(fileName);
+    if(m_data.size() < sizeof(Header))
+        return false;
+
+    m_header = reinterpret_cast<const Header*>(m_data.data());
+    if(m_header->magic != MAGIC || m_header->version != VERSION ||
+       m_header->clientVersion != key.clientVersion || m_header->datSignature != key.datSignature ||
+       m_header->datSize != key.datSize || m_header->datTime != key.datTime)
+        return false;
+
+    uint32 offset = sizeof(Header);
+    m_records = section<Record>(offset, m_header->recordCount);
+    offset += m_header->recordCount * sizeof(Record);
+    m_attributes = section<Attribute>(offset, m_header->attributeCount);
+    offset += m_header->attributeCount * sizeof(Attribute);
+    m_markets = section<Market>(offset, m_header->marketCount);
+    offset += m_header->marketCount * sizeof(Market);
+    m_sprites = section<uint32>(offset, m_header->spriteCount);
+    offset += m_header->spriteCount * sizeof(uint32);
+    m_animations = section<int32>(offset, m_header->animationCount);
+    offset += m_header->animationCount * sizeof(int32);
+    m_strings = section<char>(offset, m_header->stringsSize);
+    offset += m_header->stringsSize;
+
+    if(offset != m_data.size())
+        stdext::throw_exception("corrupt dat cache");
+    return true;
+}
+
+void ThingTypeCache::restore(ThingTypeList(&thingTypes)[ThingLastCategory], const ThingTypePtr& nullThingType)
+{
+    for(int category = 0; category < ThingLastCategory; ++category) {
+        thingTypes[category].clear();
+        thingTypes[category].resize(m_header->thingCounts[category], nullThingType);
+    }
+
+    for(uint32 i = 0; i < m_header->recordCount; ++i) {
+        const Record& record = m_records[i];
+        if(record.category >= ThingLastCategory || record.id >= thingTypes[record.category].size() ||
+           record.attributeOffset + record.attributeCount > m_header->attributeCount ||
+           record.spriteOffset + record.spriteCount > m_header->spriteCount)
+            stdext::throw_exception("corrupt dat cache");
+
+        ThingTypePtr type(new ThingType);
+        type->m_null = false;
+        type->m_id = record.id;
+        type->m_category = static_cast<ThingCategory>(record.category);
+        type->m_size = Size(record.width, record.height);
+        type->m_realSize = record.realSize;
+        type->m_exactSize = record.exactSize;
+        type->m_layers = record.layers;
+        type->m_numPatternX = record.patternX;
+        type->m_numPatternY = record.patternY;
+        type->m_numPatternZ = record.patternZ;
+        type->m_animationPhases = record.animationPhases;
+        type->m_displacement = Point(record.displacementX, record.displacementY);
+        type->m_elevation = record.elevation;
+
+        for(uint32 j = record.attributeOffset; j < record.attributeOffset + record.attributeCount; ++j) {
+            const Attribute& attribute = m_attributes[j];
+            if(attribute.attr == ThingAttrLight) {
+                Light light;
+                light.intensity = record.lightIntensity;
+                light.color = record.lightColor;
+                type->m_attribs.set(attribute.attr, light);
+            } else if(attribute.attr == ThingAttrMarket) {
+                if(record.marketIndex >= m_header->marketCount)
+                    stdext::throw_exception("corrupt dat cache");
+                const Market& cachedMarket = m_markets[record.marketIndex];
+                if(cachedMarket.nameOffset + cachedMarket.nameLength > m_header->stringsSize)
+                    stdext::throw_exception("corrupt dat cache");
+
+                MarketData market;
+                market.category = cachedMarket.category;
+                market.tradeAs = cachedMarket.tradeAs;
+                market.showAs = cachedMarket.showAs;
+                market.name.assign(m_strings + cachedMarket.nameOffset, cachedMarket.nameLength);
+                market.restrictVocation = cachedMarket.restrictVocation;
+                market.requiredLevel = cachedMarket.requiredLevel;
+                type->m_attribs.set(attribute.attr, market);
+            } else if(attribute.hasValue)
+                type->m_attribs.set(attribute.attr, attribute.value);
+            else
+                type->m_attribs.set(attribute.attr, true);
+        }
+
+        type->m_spritesIndex.assign(m_sprites + record.spriteOffset, m_sprites + record.spriteOffset + record.spriteCount);
+        type->m_animator = restoreAnimator(record.animatorOffset);
+        type->m_idleAnimator = restoreAnimator(record.idleAnimatorOffset);
+        type->resetTextures();
+
+        thingTypes[record.category][record.id] = type;
+    }
+}
+
+void ThingTypeCache::save(const std::string& fileName, const Key& key, const ThingTypeList(&thingTypes)[ThingLastCategory])
+{
+    Header header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.clientVersion = key.clientVersion;
+    header.datSignature = key.datSignature;
+    header.datSize = key.datSize;
+    header.datTime = key.datTime;
+
+    for(int category = 0; category < ThingLastCategory; ++category) {
+        header.thingCounts[category] = thingTypes[category].size();
+        for(const ThingTypePtr& type : thingTypes[category]) {
+            if(type && !type->isNull())
+                compile(type);
+        }
+    }
+
+    header.recordCount = m_newRecords.size();
+    header.attributeCount = m_newAttributes.size();
+    header.marketCount = m_newMarkets.size();
+    header.spriteCount = m_newSprites.size();
+    header.animationCount = m_newAnimations.size();
+    header.stringsSize = m_newStrings.size();
+
+    std::string data;
+    data.reserve(sizeof(Header) + m_newRecords.size() * sizeof(Record) + m_newAttributes.size() * sizeof(Attribute) +
+                 m_newMarkets.size() * sizeof(Market) + m_newSprites.size() * sizeof(uint32) +
+                 m_newAnimations.size() * sizeof(int32) + m_newStrings.size());
+    data.append(reinterpret_cast<const char*>(&header), sizeof(Header));
+    data.append(reinterpret_cast<const char*>(m_newRecords.data()), m_newRecords.size() * sizeof(Record));
+    data.append(reinterpret_cast<const char*>(m_newAttributes.data()), m_newAttributes.size() * sizeof(Attribute));
+    data.append(reinterpret_cast<const char*>(m_newMarkets.data()), m_newMarkets.size() * sizeof(Market));
+    data.append(reinterpret_cast<const char*>(m_newSprites.data()), m_newSprites.size() * sizeof(uint32));
+    data.append(reinterpret_cast<const char*>(m_newAnimations.data()), m_newAnimations.size() * sizeof(int32));
+    data.append(m_newStrings);
+
+    const auto slash = fileName.find_last_of('/');
+    if(slash != std::string::npos && slash > 0)
+        g_resources.makeDir(fileName.substr(0, slash));
+    g_resources.writeFileBuffer(fileName, reinterpret_cast<const uchar*>(data.data()), data.size());
+}
+
+void ThingTypeCache::compile(const ThingTypePtr& type)
+{
+    Record record = {};
+    record.id = type->m_id;
+    record.category = type->m_category;
+    record.width = type->m_size.width();
+    record.height = type->m_size.height();
+    record.realSize = type->m_realSize;
+    record.layers = type->m_layers;
+    record.patternX = type->m_numPatternX;
+    record.patternY = type->m_numPatternY;
+    record.patternZ = type->m_numPatternZ;
+    record.animationPhases = type->m_animationPhases;
+    record.exactSize = type->m_exactSize;
+    record.displacementX = type->m_displacement.x;
+    record.displacementY = type->m_displacement.y;
+    record.elevation = type->m_elevation;
+    record.marketIndex = NONE;
+
+    record.attributeOffset = m_newAttributes.size();
+    for(int attr = 0; attr < ThingLastAttr; ++attr) {
+        if(!type->m_attribs.has(attr))
+            continue;
+
+        Attribute attribute = {};
+        attribute.attr = attr;
+        if(attr == ThingAttrLight) {
+            const Light light = type->m_attribs.get<Light>(attr);
+            record.lightIntensity = light.intensity;
+            record.lightColor = light.color;
+        } else if(attr == ThingAttrMarket) {
+            const MarketData market = type->m_attribs.get<MarketData>(attr);
+            Market cachedMarket = {};
+            cachedMarket.category = market.category;
+            cachedMarket.tradeAs = market.tradeAs;
+            cachedMarket.showAs = market.showAs;
+            cachedMarket.restrictVocation = market.restrictVocation;
+            cachedMarket.requiredLevel = market.requiredLevel;
+            cachedMarket.nameLength = market.name.size();
+            cachedMarket.nameOffset = m_newStrings.size();
+            m_newStrings += market.name;
+            record.marketIndex = m_newMarkets.size();
+            m_newMarkets.push_back(cachedMarket);
+        } else if(hasAttrValue(attr)) {
+            attribute.hasValue = 1;
+            attribute.value = type->m_attribs.get<uint16>(attr);
+        }
+        m_newAttributes.push_back(attribute);
+    }
+    record.attributeCount = m_newAttributes.size() - record.attributeOffset;
+
+    record.spriteOffset = m_newSprites.size();
+    record.spriteCount = type->m_spritesIndex.size();
+    m_newSprites.insert(m_newSprites.end(), type->m_spritesIndex.begin(), type->m_spritesIndex.end());
+
+    record.animatorOffset = compileAnimator(type->m_animator);
+    record.idleAnimatorOffset = compileAnimator(type->m_idleAnimator);
+
+    m_newRecords.push_back(record);
+}
+
+uint32 ThingTypeCache::compileAnimator(const AnimatorPtr& animator)
+{
+    if(!animator)
+        return NONE;
+
+    const uint32 offset = m_newAnimations.size();
+    m_newAnimations.push_back(animator->m_animationPhases);
+    m_newAnimations.push_back(animator->m_async ? 1 : 0);
+    m_newAnimations.push_back(animator->m_loopCount);
+    m_newAnimations.push_back(animator->m_startPhase);
+    for(const auto& duration : animator->m_phaseDurations) {
+        m_newAnimations.push_back(std::get<0>(duration));
+        m_newAnimations.push_back(std::get<1>(duration));
+    }
+    return offset;
+}
+
+AnimatorPtr ThingTypeCache::restoreAnimator(uint32 offset)
+{
+    if(offset == NONE)
+        return nullptr;
+
+    if(offset + 4 > m_header->animationCount)
+        stdext::throw_exception("corrupt dat cache");
+
+    const int32* data = m_animations + offset;
+    const int animationPhases = data[0];
+    if(animationPhases < 0 || offset + 4 + 2 * static_cast<uint64>(animationPhases) > m_header->animationCount)
+        stdext::throw_exception("corrupt dat cache");
+
+    auto animator = AnimatorPtr(new Animator);
+    animator->m_animationPhases = animationPhases;
+    animator->m_async = data[1] != 0;
+    animator->m_loopCount = data[2];
+    animator->m_startPhase = data[3];
+    for(int i = 0; i < animationPhases; ++i)
+        animator->m_phaseDurations.emplace_back(data[4 + 2 * i], data[5 + 2 * i]);
+    animator->m_phase = animator->getStartPhase();
+    return animator;
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef THINGTYPECACHE_H
+#define THINGTYPECACHE_H
+
+#include <client/thing/type/thingtype.h>
+
+// compiled .dat cache, a flat offset based layout keyed by the dat stamp and client version
+class ThingTypeCache
+{
+public:
+    static constexpr uint32 MAGIC = 0x4344544f; // "OTDC"
+    static constexpr uint16 VERSION = 1;
+    static constexpr uint32 NONE = 0xFFFFFFFF;
+
+    struct Key {
+        uint32 datSignature;
+        uint32 datSize;
+        uint64 datTime;
+        uint16 clientVersion;
+    };
+
+    struct Header {
+        uint32 magic;
+        uint16 version;
+        uint16 clientVersion;
+        uint32 datSignature;
+        uint32 datSize;
+        uint64 datTime;
+        uint32 thingCounts[ThingLastCategory];
+        uint32 recordCount;
+        uint32 attributeCount;
+        uint32 marketCount;
+        uint32 spriteCount;
+        uint32 animationCount;
+        uint32 stringsSize;
+    };
+
+    struct Record {
+        uint16 id;
+        uint8 category;
+        uint8 width;
+        uint8 height;
+        uint8 realSize;
+        uint8 layers;
+        uint8 patternX;
+        uint8 patternY;
+        uint8 patternZ;
+        uint8 lightIntensity;
+        uint8 lightColor;
+        uint16 animationPhases;
+        uint16 exactSize;
+        uint16 displacementX;
+        uint16 displacementY;
+        uint16 elevation;
+        uint16 attributeCount;
+        uint32 attributeOffset;
+        uint32 spriteOffset;
+        uint32 spriteCount;
+        uint32 marketIndex;
+        uint32 animatorOffset;
+        uint32 idleAnimatorOffset;
+    };
+
+    struct Attribute {
+        uint8 attr;
+        uint8 hasValue;
+        uint16 value;
+    };
+
+    struct Market {
+        uint16 category;
+        uint16 tradeAs;
+        uint16 showAs;
+        uint16 restrictVocation;
+        uint16 requiredLevel;
+        uint16 nameLength;
+        uint32 nameOffset;
+    };
+
+    // returns false if the cache is missing or stale
+    bool load(const std::string& fileName, const Key& key);
+    void restore(ThingTypeList (&thingTypes)[ThingLastCategory], const ThingTypePtr& nullThingType);
+
+    void save(const std::string& fileName, const Key& key, const ThingTypeList (&thingTypes)[ThingLastCategory]);
+
+private:
+    void compile(const ThingTypePtr& thingType);
+    uint32 compileAnimator(const AnimatorPtr& animator);
+    AnimatorPtr restoreAnimator(uint32 offset);
+
+    template<typename T>
+    const T* section(uint32 offset, uint32 count);
+
+    std::string m_data;
+    const Header* m_header{ nullptr };
+    const Record* m_records{ nullptr };
+    const Attribute* m_attributes{ nullptr };
+    const Market* m_markets{ nullptr };
+    const uint32* m_sprites{ nullptr };
+    const int32* m_animations{ nullptr };
+    const char* m_strings{ nullptr };
+
+    std::vector<Record> m_newRecords;
+    std::vector<Attribute> m_newAttributes;
+    std::vector<Market> m_newMarkets;
+    std::vector<uint32> m_newSprites;
+    std::vector<int32> m_newAnimations;
+    std::string m_newStrings;
+};
+
+static_assert(sizeof(ThingTypeCache::Header) == 64, "dat cache layout changed");
+static_assert(sizeof(ThingTypeCache::Record) == 48, "dat cache layout changed");
+static_assert(sizeof(ThingTypeCache::Attribute) == 4, "dat cache layout changed");
+static_assert(sizeof(ThingTypeCache::Market) == 16, "dat cache layout changed");
+
+#endif
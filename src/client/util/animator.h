@@ -66,6 +66,8 @@ private:
 
     void calculateSynchronous();
 
+    friend class ThingTypeCache;
+
     int m_currentDuration{ 0 };
     int m_animationPhases{ 0 };
     int m_currentLoop{ 0 };
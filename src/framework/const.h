@@ -184,6 +184,12 @@ namespace Fw
         LogFatal
     };
 
+    enum EventPriority {
+        UIEventPriority = 0,
+        BackgroundEventPriority,
+        LastEventPriority
+    };
+
     enum AspectRatioMode {
         IgnoreAspectRatio,
         KeepAspectRatio,
@@ -27,6 +27,7 @@
 #include <framework/core/modulemanager.h>
 #include <framework/core/eventdispatcher.h>
 #include <framework/core/configmanager.h>
+#include <framework/core/profiler.h>
 #include "asyncdispatcher.h"
 #include <framework/luaengine/luainterface.h>
 #include <framework/platform/crashhandler.h>
@@ -146,10 +147,16 @@ void Application::terminate()
 void Application::poll()
 {
 #ifdef FW_NET
-    Connection::poll();
+    {
+        PROFILE_SCOPE("network poll");
+        Connection::poll();
+    }
 #endif
 
-    g_dispatcher.poll();
+    {
+        PROFILE_SCOPE("dispatcher poll");
+        g_dispatcher.poll();
+    }
 
     // poll connection again to flush pending write
 #ifdef FW_NET
@@ -21,24 +21,49 @@
  */
 
 #include "asyncdispatcher.h"
+#include "eventdispatcher.h"
 
 AsyncDispatcher g_asyncDispatcher;
 
+// index of the worker running in the current thread, -1 outside of the pool
+static thread_local int currentWorker = -1;
+
 void AsyncDispatcher::init()
 {
-    spawn_thread();
+    // the main thread is busy rendering, so it is left out of the worker count
+    spawn_threads(std::max<int>(std::thread::hardware_concurrency(), 2) - 1);
+
+    if(!m_pollRegistered) {
+        g_dispatcher.addPollCallback([this] { poll(); });
+        m_pollRegistered = true;
+    }
 }
 
 void AsyncDispatcher::terminate()
 {
     stop();
-    m_tasks.clear();
+    m_workers.clear();
+
+    // the last tasks may have queued logs or results for the main thread, they still run,
+    // and so do the ones those queue in turn
+    while(true) {
+        {
+            std::lock_guard<std::mutex> lock(m_mainMutex);
+            if(m_mainTasks.empty())
+                break;
+        }
+        poll();
+    }
 }
 
-void AsyncDispatcher::spawn_thread()
+void AsyncDispatcher::spawn_threads(int count)
 {
+    // workers look into each other deques, so all of them must exist before any thread starts
     m_running = true;
-    m_threads.emplace_back([this] { exec_loop(); });
+    for(int i = 0; i < count; ++i)
+        m_workers.emplace_back(std::make_unique<Worker>());
+    for(int i = 0; i < count; ++i)
+        m_workers[i]->thread = std::thread([this, i] { exec_loop(i); });
 }
 
 void AsyncDispatcher::stop()
@@ -47,26 +72,168 @@ void AsyncDispatcher::stop()
     m_running = false;
     m_condition.notify_all();
     m_mutex.unlock();
-    for(std::thread& thread : m_threads)
-        thread.join();
-    m_threads.clear();
-};
+    for(const auto& worker : m_workers) {
+        if(worker->thread.joinable())
+            worker->thread.join();
+    }
+
+    // workers drain their deques before leaving, anything dispatched meanwhile runs here
+    while(runPendingTask());
+}
+
+void AsyncDispatcher::dispatch(const std::function<void()>& task, Priority priority, const AsyncTaskGroupPtr& group)
+{
+    if(m_workers.empty()) {
+        // not initialized yet or already terminated, run it right away
+        Task inlineTask{ task, group };
+        execute(inlineTask);
+        return;
+    }
+
+    // tasks spawned by a worker stay close to it, the others are spread over all workers
+    const int workerId = currentWorker >= 0 ? currentWorker : m_nextWorker++ % m_workers.size();
+    Worker& worker = *m_workers[workerId];
 
-void AsyncDispatcher::exec_loop()
+    // the counter is raised under the sleep mutex so a worker about to wait can't miss it,
+    // and before the task is visible so popping it never takes the counter below zero
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_pendingTasks;
+    {
+        std::lock_guard<std::mutex> workerLock(worker.mutex);
+        worker.tasks[priority].push_back({ task, group });
+    }
+    m_condition.notify_one();
+}
+
+void AsyncDispatcher::dispatchToMain(const std::function<void()>& task)
 {
-    std::unique_lock<std::mutex> lock(m_mutex);
+    std::lock_guard<std::mutex> lock(m_mainMutex);
+    m_mainTasks.push_back(task);
+}
+
+bool AsyncDispatcher::runPendingTask()
+{
+    if(m_workers.empty())
+        return false;
+
+    Task task;
+    if(!popTask(std::max<int>(currentWorker, 0), task))
+        return false;
+
+    execute(task);
+    return true;
+}
+
+void AsyncDispatcher::exec_loop(int workerId)
+{
+    currentWorker = workerId;
     while(true) {
-        while(m_tasks.empty() && m_running)
-            m_condition.wait(lock);
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(m_pendingTasks == 0 && m_running)
+                m_condition.wait(lock);
 
-        if(!m_running)
-            return;
+            // queued tasks still run when stopping, someone may be waiting for their group
+            if(!m_running && m_pendingTasks == 0)
+                return;
+        }
+
+        Task task;
+        if(popTask(workerId, task))
+            execute(task);
+    }
+}
 
-        std::function<void()> task = m_tasks.front();
-        m_tasks.pop_front();
+void AsyncDispatcher::poll()
+{
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(m_mainMutex);
+        if(m_mainTasks.empty())
+            return;
+        tasks.swap(m_mainTasks);
+    }
 
-        lock.unlock();
+    for(const auto& task : tasks)
         task();
-        lock.lock();
+}
+
+bool AsyncDispatcher::popTask(int workerId, Task& task)
+{
+    const int workers = m_workers.size();
+    for(int priority = 0; priority < LastPriority; ++priority) {
+        // newest task of our own deque first, it is the most likely to be hot in cache
+        {
+            Worker& worker = *m_workers[workerId];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            auto& tasks = worker.tasks[priority];
+            if(!tasks.empty()) {
+                task = std::move(tasks.back());
+                tasks.pop_back();
+                --m_pendingTasks;
+                return true;
+            }
+        }
+
+        // then steal the oldest task of another worker
+        for(int i = 1; i < workers; ++i) {
+            Worker& victim = *m_workers[(workerId + i) % workers];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            auto& tasks = victim.tasks[priority];
+            if(!tasks.empty()) {
+                task = std::move(tasks.front());
+                tasks.pop_front();
+                --m_pendingTasks;
+                ++m_stolenTasks;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void AsyncDispatcher::execute(Task& task)
+{
+    if(!task.group || !task.group->isCanceled()) {
+        try {
+            task.callback();
+        } catch(std::exception& e) {
+            // the logger posts to the main dispatcher, which is not thread safe
+            const std::string message = stdext::format("async task failed: %s", e.what());
+            if(currentWorker >= 0)
+                dispatchToMain([message] { g_logger.error(message); });
+            else
+                g_logger.error(message);
+        }
+    }
+    ++m_executedTasks;
+
+    if(task.group)
+        task.group->finish();
+}
+
+void AsyncTaskGroup::schedule(const std::function<void()>& task, AsyncDispatcher::Priority priority)
+{
+    ++m_pending;
+    g_asyncDispatcher.dispatch(task, priority, shared_from_this());
+}
+
+void AsyncTaskGroup::wait()
+{
+    while(m_pending > 0) {
+        // help with the queued work instead of just blocking, a worker may be the one waiting
+        if(g_asyncDispatcher.runPendingTask())
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait_for(lock, std::chrono::milliseconds(1), [this] { return m_pending == 0; });
+    }
+}
+
+void AsyncTaskGroup::finish()
+{
+    if(--m_pending == 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_condition.notify_all();
     }
 }
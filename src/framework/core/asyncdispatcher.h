@@ -26,33 +26,114 @@
 #include "declarations.h"
 #include <framework/stdext/thread.h>
 
+#include <atomic>
+
+// Work stealing thread pool shared by everything that runs off the main thread.
+// Every worker owns a deque per priority, tasks submitted from a worker stay in its own deques
+// and idle workers steal the oldest tasks of the others.
 class AsyncDispatcher {
 public:
+    enum Priority {
+        HighPriority = 0,
+        NormalPriority,
+        LowPriority,
+        LastPriority
+    };
+
     void init();
     void terminate();
 
-    void spawn_thread();
     void stop();
 
     template<class F>
-    boost::shared_future<typename std::result_of<F()>::type> schedule(const F& task)
+    boost::shared_future<typename std::result_of<F()>::type> schedule(const F& task, Priority priority = NormalPriority)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
         auto prom = std::make_shared<boost::promise<typename std::result_of<F()>::type>>();
-        m_tasks.push_back([=]() { prom->set_value(task()); });
-        m_condition.notify_all();
+        dispatch([=]() { prom->set_value(task()); }, priority);
         return boost::shared_future<typename std::result_of<F()>::type>(prom->get_future());
     }
 
+    // runs task in a worker, then hands its result to continuation in the main thread
+    template<class F, class C>
+    void scheduleThen(const F& task, const C& continuation, Priority priority = NormalPriority)
+    {
+        dispatch([=]() {
+            if constexpr(std::is_void<typename std::result_of<F()>::type>::value) {
+                task();
+                dispatchToMain(continuation);
+            } else {
+                auto result = task();
+                dispatchToMain([=]() { continuation(result); });
+            }
+        }, priority);
+    }
+
+    void dispatch(const std::function<void()>& task, Priority priority = NormalPriority, const AsyncTaskGroupPtr& group = nullptr);
+    void dispatchToMain(const std::function<void()>& task);
+
+    // executes one queued task in the calling thread, used while waiting for task groups
+    bool runPendingTask();
+
+    int getWorkerCount() { return m_workers.size(); }
+    int getPendingTaskCount() { return m_pendingTasks; }
+    uint64 getExecutedTaskCount() { return m_executedTasks; }
+    uint64 getStolenTaskCount() { return m_stolenTasks; }
+
 protected:
-    void exec_loop();
+    void spawn_threads(int count);
+    void exec_loop(int workerId);
+    void poll();
 
 private:
-    std::list<std::function<void()>> m_tasks;
-    std::list<std::thread> m_threads;
+    struct Task {
+        std::function<void()> callback;
+        AsyncTaskGroupPtr group;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::array<std::deque<Task>, LastPriority> tasks;
+        std::thread thread;
+    };
+
+    bool popTask(int workerId, Task& task);
+    void execute(Task& task);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
     std::mutex m_mutex;
     std::condition_variable m_condition;
+    std::atomic<int> m_pendingTasks{ 0 };
+    std::atomic<uint> m_nextWorker{ 0 };
+    std::atomic<uint64> m_executedTasks{ 0 };
+    std::atomic<uint64> m_stolenTasks{ 0 };
     bool m_running{ false };
+    bool m_pollRegistered{ false };
+
+    std::mutex m_mainMutex;
+    std::vector<std::function<void()>> m_mainTasks;
+};
+
+// Set of tasks that can be waited for or canceled together, tasks not started yet are skipped once canceled.
+// Groups are shared with the queued tasks, so they must be created with std::make_shared.
+class AsyncTaskGroup : public std::enable_shared_from_this<AsyncTaskGroup>
+{
+public:
+    void schedule(const std::function<void()>& task, AsyncDispatcher::Priority priority = AsyncDispatcher::NormalPriority);
+    void wait();
+    void cancel() { m_canceled = true; }
+
+    bool isCanceled() { return m_canceled; }
+    int getPendingCount() { return m_pending; }
+
+private:
+    void finish();
+
+    std::atomic<int> m_pending{ 0 };
+    std::atomic<bool> m_canceled{ false };
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+
+    friend class AsyncDispatcher;
 };
 
 extern AsyncDispatcher g_asyncDispatcher;
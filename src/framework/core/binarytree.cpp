@@ -26,157 +26,135 @@
 #include "filestream.h"
 #include "framework/stdext/math.h"
 
-BinaryTree::BinaryTree(const FileStreamPtr& fin) :
-    m_fin(fin), m_pos(0xFFFFFFFF)
-{
-    m_startPos = fin->tell();
-}
-
-BinaryTree::~BinaryTree()
-= default;
-
-void BinaryTree::skipNodes()
-{
-    while(true) {
-        const uint8 byte = m_fin->getU8();
+uint BinaryTree::unserialize(const uint8* data, uint size)
+{
+    // data starts right after the root node start byte, escaped bytes are
+    // unescaped into one contiguous buffer and nodes keep ranges into it
+    m_nodes.clear();
+    m_data.resize(size);
+
+    std::vector<std::pair<uint32, uint32>> stack; // node id, last child id
+    m_nodes.push_back({ 0, InvalidNode, InvalidNode, InvalidNode });
+    stack.emplace_back(0, InvalidNode);
+
+    uint8* out = m_data.data();
+    uint32 written = 0;
+    uint pos = 0;
+    while(pos < size) {
+        uint8 byte = data[pos++];
         switch(byte) {
         case BINARYTREE_NODE_START:
         {
-            skipNodes();
+            auto& parent = stack.back();
+            Node& parentNode = m_nodes[parent.first];
+            if(parentNode.end == InvalidNode)
+                parentNode.end = written;
+
+            const uint32 id = m_nodes.size();
+            if(parent.second == InvalidNode)
+                parentNode.firstChild = id;
+            else
+                m_nodes[parent.second].nextSibling = id;
+            parent.second = id;
+
+            m_nodes.push_back({ written, InvalidNode, InvalidNode, InvalidNode });
+            stack.emplace_back(id, InvalidNode);
             break;
         }
         case BINARYTREE_NODE_END:
-            return;
-        case BINARYTREE_ESCAPE_CHAR:
-            m_fin->getU8();
-            break;
-        default:
-            break;
-        }
-    }
-}
-
-void BinaryTree::unserialize()
-{
-    if(m_pos != 0xFFFFFFFF)
-        return;
-    m_pos = 0;
-
-    m_fin->seek(m_startPos);
-    while(true) {
-        uint8 byte = m_fin->getU8();
-        switch(byte) {
-        case BINARYTREE_NODE_START:
         {
-            skipNodes();
+            Node& node = m_nodes[stack.back().first];
+            if(node.end == InvalidNode)
+                node.end = written;
+
+            stack.pop_back();
+            if(stack.empty()) {
+                m_data.resize(written);
+                return pos;
+            }
             break;
         }
-        case BINARYTREE_NODE_END:
-            return;
         case BINARYTREE_ESCAPE_CHAR:
-            m_buffer.add(m_fin->getU8());
-            break;
+            if(pos >= size)
+                stdext::throw_exception("BinaryTree: unexpected end of data after escape char");
+            byte = data[pos++];
+            [[fallthrough]];
         default:
-            m_buffer.add(byte);
+            if(unlikely(m_nodes[stack.back().first].end != InvalidNode))
+                stdext::throw_exception("BinaryTree: unexpected node data after children");
+            out[written++] = byte;
             break;
         }
     }
+
+    stdext::throw_exception("BinaryTree: unexpected end of data, node was not closed");
+    return pos;
 }
 
-BinaryTreeVec BinaryTree::getChildren()
+BinaryTreeNode BinaryTree::getRoot() const
 {
-    BinaryTreeVec children;
-    m_fin->seek(m_startPos);
-    while(true) {
-        const uint8 byte = m_fin->getU8();
-        switch(byte) {
-        case BINARYTREE_NODE_START:
-        {
-            BinaryTreePtr node(new BinaryTree(m_fin));
-            children.push_back(node);
-            node->skipNodes();
-            break;
-        }
-        case BINARYTREE_NODE_END:
-            return children;
-        case BINARYTREE_ESCAPE_CHAR:
-            m_fin->getU8();
-            break;
-        default:
-            break;
-        }
-    }
+    if(m_nodes.empty())
+        stdext::throw_exception("BinaryTree: tree was not unserialized");
+    return { this, 0 };
 }
 
-void BinaryTree::seek(uint pos)
+void BinaryTreeNode::seek(uint pos)
 {
-    unserialize();
-    if(pos > m_buffer.size())
+    if(pos > m_size)
         stdext::throw_exception("BinaryTree: seek failed");
     m_pos = pos;
 }
 
-void BinaryTree::skip(uint len)
+uint8 BinaryTreeNode::getU8()
 {
-    unserialize();
-    seek(tell() + len);
-}
-
-uint8 BinaryTree::getU8()
-{
-    unserialize();
-    if(m_pos + 1 > m_buffer.size())
+    if(m_pos + 1 > m_size)
         stdext::throw_exception("BinaryTree: getU8 failed");
-    const uint8 v = m_buffer[m_pos];
+    const uint8 v = m_data[m_pos];
     m_pos += 1;
     return v;
 }
 
-uint16 BinaryTree::getU16()
+uint16 BinaryTreeNode::getU16()
 {
-    unserialize();
-    if(m_pos + 2 > m_buffer.size())
+    if(m_pos + 2 > m_size)
         stdext::throw_exception("BinaryTree: getU16 failed");
-    const uint16 v = stdext::readULE16(&m_buffer[m_pos]);
+    const uint16 v = stdext::readULE16(m_data + m_pos);
     m_pos += 2;
     return v;
 }
 
-uint32 BinaryTree::getU32()
+uint32 BinaryTreeNode::getU32()
 {
-    unserialize();
-    if(m_pos + 4 > m_buffer.size())
+    if(m_pos + 4 > m_size)
         stdext::throw_exception("BinaryTree: getU32 failed");
-    const uint32 v = stdext::readULE32(&m_buffer[m_pos]);
+    const uint32 v = stdext::readULE32(m_data + m_pos);
     m_pos += 4;
     return v;
 }
 
-uint64 BinaryTree::getU64()
+uint64 BinaryTreeNode::getU64()
 {
-    unserialize();
-    if(m_pos + 8 > m_buffer.size())
+    if(m_pos + 8 > m_size)
         stdext::throw_exception("BinaryTree: getU64 failed");
-    const uint64 v = stdext::readULE64(&m_buffer[m_pos]);
+    const uint64 v = stdext::readULE64(m_data + m_pos);
     m_pos += 8;
     return v;
 }
 
-std::string BinaryTree::getString(uint16 len)
+std::string BinaryTreeNode::getString(uint16 len)
 {
-    unserialize();
     if(len == 0)
         len = getU16();
 
-    if(m_pos + len > m_buffer.size())
+    if(m_pos + len > m_size)
         stdext::throw_exception("BinaryTree: getString failed: string length exceeded buffer size.");
 
-    std::string ret((char*)&m_buffer[m_pos], len);
+    std::string ret((const char*)m_data + m_pos, len);
     m_pos += len;
     return ret;
 }
 
-Point BinaryTree::getPoint()
+Point BinaryTreeNode::getPoint()
 {
     Point ret;
     ret.x = getU8();
@@ -184,6 +162,22 @@ Point BinaryTree::getPoint()
     return ret;
 }
 
+BinaryTreeNode BinaryTreeNode::getFirstChild() const
+{
+    const uint32 id = m_tree->m_nodes[m_id].firstChild;
+    if(id == BinaryTree::InvalidNode)
+        stdext::throw_exception("BinaryTree: node has no children");
+    return { m_tree, id };
+}
+
+uint BinaryTreeNode::getChildrenCount() const
+{
+    uint count = 0;
+    for(uint32 id = m_tree->m_nodes[m_id].firstChild; id != BinaryTree::InvalidNode; id = m_tree->m_nodes[id].nextSibling)
+        ++count;
+    return count;
+}
+
 OutputBinaryTree::OutputBinaryTree(FileStreamPtr fin)
     : m_fin(std::move(fin))
 {
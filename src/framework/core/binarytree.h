@@ -24,7 +24,7 @@
 #define BINARYTREE_H
 
 #include "declarations.h"
-#include <framework/util/databuffer.h>
+#include <framework/util/point.h>
 
 enum {
     BINARYTREE_ESCAPE_CHAR = 0xFD,
@@ -32,16 +32,74 @@ enum {
     BINARYTREE_NODE_END = 0xFF
 };
 
+// parsed node tree, unescaped in a single pass over the file buffer
 class BinaryTree : public stdext::shared_object
 {
 public:
-    BinaryTree(const FileStreamPtr& fin);
-    ~BinaryTree() override;
+    enum : uint32 { InvalidNode = 0xFFFFFFFF };
+
+    uint unserialize(const uint8* data, uint size);
+
+    BinaryTreeNode getRoot() const;
+    uint getNodeCount() const { return m_nodes.size(); }
+
+private:
+    struct Node
+    {
+        uint32 begin;
+        uint32 end;
+        uint32 firstChild;
+        uint32 nextSibling;
+    };
+
+    std::vector<Node> m_nodes;
+    std::vector<uint8> m_data;
+
+    friend class BinaryTreeNode;
+};
+
+// lightweight view of a single node, reads directly from the tree buffer
+class BinaryTreeNode
+{
+public:
+    class Iterator
+    {
+    public:
+        Iterator(const BinaryTree* tree, uint32 id) : m_tree(tree), m_id(id) {}
+
+        BinaryTreeNode operator*() const { return { m_tree, m_id }; }
+        Iterator& operator++() { m_id = m_tree->m_nodes[m_id].nextSibling; return *this; }
+        bool operator!=(const Iterator& other) const { return m_id != other.m_id; }
+        bool operator==(const Iterator& other) const { return m_id == other.m_id; }
+
+    private:
+        const BinaryTree* m_tree;
+        uint32 m_id;
+    };
+
+    class Children
+    {
+    public:
+        Children(const BinaryTree* tree, uint32 first) : m_tree(tree), m_first(first) {}
+
+        Iterator begin() const { return { m_tree, m_first }; }
+        Iterator end() const { return { m_tree, BinaryTree::InvalidNode }; }
+        bool empty() const { return m_first == BinaryTree::InvalidNode; }
+
+    private:
+        const BinaryTree* m_tree;
+        uint32 m_first;
+    };
+
+    BinaryTreeNode(const BinaryTree* tree, uint32 id) :
+        m_data(tree->m_data.data() + tree->m_nodes[id].begin),
+        m_size(tree->m_nodes[id].end - tree->m_nodes[id].begin),
+        m_pos(0), m_tree(tree), m_id(id) {}
 
     void seek(uint pos);
-    void skip(uint len);
-    uint tell() { return m_pos; }
-    uint size() { unserialize(); return m_buffer.size(); }
+    void skip(uint len) { seek(m_pos + len); }
+    uint tell() const { return m_pos; }
+    uint size() const { return m_size; }
 
     uint8 getU8();
     uint16 getU16();
@@ -50,17 +108,17 @@ public:
     std::string getString(uint16 len = 0);
     Point getPoint();
 
-    BinaryTreeVec getChildren();
-    bool canRead() { unserialize(); return m_pos < m_buffer.size(); }
+    BinaryTreeNode getFirstChild() const;
+    Children getChildren() const { return { m_tree, m_tree->m_nodes[m_id].firstChild }; }
+    uint getChildrenCount() const;
+    bool canRead() const { return m_pos < m_size; }
 
 private:
-    void unserialize();
-    void skipNodes();
-
-    FileStreamPtr m_fin;
-    DataBuffer<uint8> m_buffer;
+    const uint8* m_data;
+    uint m_size;
     uint m_pos;
-    uint m_startPos;
+    const BinaryTree* m_tree;
+    uint32 m_id;
 };
 
 class OutputBinaryTree : public stdext::shared_object
@@ -45,6 +45,7 @@ void ConsoleApplication::run()
 
     while(!m_stopping) {
         poll();
+        g_lua.stepGarbageCollector(g_lua.getGarbageCollectorMaxStepTime());
         stdext::millisleep(1);
         g_clock.update();
         m_frameCounter.update();
@@ -34,7 +34,9 @@ class Event;
 class ScheduledEvent;
 class FileStream;
 class BinaryTree;
+class BinaryTreeNode;
 class OutputBinaryTree;
+class AsyncTaskGroup;
 
 using ModulePtr = stdext::shared_object_ptr<Module>;
 using ConfigPtr = stdext::shared_object_ptr<Config>;
@@ -43,7 +45,7 @@ using ScheduledEventPtr = stdext::shared_object_ptr<ScheduledEvent>;
 using FileStreamPtr = stdext::shared_object_ptr<FileStream>;
 using BinaryTreePtr = stdext::shared_object_ptr<BinaryTree>;
 using OutputBinaryTreePtr = stdext::shared_object_ptr<OutputBinaryTree>;
+using AsyncTaskGroupPtr = std::shared_ptr<AsyncTaskGroup>;
 
-using BinaryTreeVec = std::vector<BinaryTreePtr>;
 
 #endif
@@ -22,13 +22,111 @@
 
 #include "event.h"
 
+#include <mutex>
 #include <utility>
+#include <vector>
 
-Event::Event(std::function<void()> callback) :
+std::atomic<uint64> Event::m_createdCount{ 0 };
+std::atomic<uint64> Event::m_heapAllocationCount{ 0 };
+
+namespace {
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    // Event and ScheduledEvent each get their own list, keyed by object size
+    struct FreeList
+    {
+        std::size_t size;
+        FreeBlock* head;
+    };
+
+    // events are mostly created in the main thread, but nothing stops a worker from posting one
+    struct EventPool
+    {
+        std::mutex mutex;
+        std::vector<FreeList> freeLists;
+        bool released{ false };
+    };
+
+    // never destroyed, other statics may still release events after their destruction order
+    EventPool& getPool()
+    {
+        static EventPool* pool = new EventPool;
+        return *pool;
+    }
+
+    FreeList& getFreeList(EventPool& pool, std::size_t size)
+    {
+        for(FreeList& list : pool.freeLists) {
+            if(list.size == size)
+                return list;
+        }
+        pool.freeLists.push_back({ size, nullptr });
+        return pool.freeLists.back();
+    }
+}
+
+Event::Event(EventCallback callback) :
     m_callback(std::move(callback)),
     m_canceled(false),
     m_executed(false)
 {
+    ++m_createdCount;
+}
+
+void* Event::operator new(std::size_t size)
+{
+    EventPool& pool = getPool();
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if(!pool.released) {
+            FreeList& list = getFreeList(pool, size);
+            if(FreeBlock* block = list.head) {
+                list.head = block->next;
+                return block;
+            }
+        }
+    }
+
+    ++m_heapAllocationCount;
+    return ::operator new(size);
+}
+
+void Event::operator delete(void* ptr, std::size_t size)
+{
+    if(!ptr)
+        return;
+
+    // blocks are kept for reuse, the pools only grow up to the peak of live events
+    EventPool& pool = getPool();
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if(!pool.released) {
+            FreeList& list = getFreeList(pool, size);
+            FreeBlock* block = static_cast<FreeBlock*>(ptr);
+            block->next = list.head;
+            list.head = block;
+            return;
+        }
+    }
+
+    ::operator delete(ptr);
+}
+
+void Event::releasePool()
+{
+    EventPool& pool = getPool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    for(FreeList& list : pool.freeLists) {
+        while(FreeBlock* block = list.head) {
+            list.head = block->next;
+            ::operator delete(block);
+        }
+    }
+    pool.freeLists.clear();
+    pool.released = true;
 }
 
 Event::~Event()
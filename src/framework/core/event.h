@@ -24,24 +24,43 @@
 #define EVENT_H
 
 #include <framework/luaengine/luaobject.h>
+#include <framework/stdext/inplace_function.h>
+
+#include <atomic>
+
+// sized to keep the common lambdas capturing a few object refs, or a whole std::function, inline
+using EventCallback = stdext::inplace_function<void(), 48>;
 
  // @bindclass
 class Event : public LuaObject
 {
 public:
-    Event(std::function<void()> callback);
+    Event(EventCallback callback);
     ~Event() override;
 
+    // event objects are recycled through locked free lists
+    static void* operator new(std::size_t size);
+    static void operator delete(void* ptr, std::size_t size);
+    // frees the pooled blocks, events released afterwards go straight back to the heap
+    static void releasePool();
+
+    static uint64 getCreatedCount() { return m_createdCount; }
+    static uint64 getHeapAllocationCount() { return m_heapAllocationCount; }
+
     virtual void execute();
-    void cancel();
+    virtual void cancel();
 
     bool isCanceled() { return m_canceled; }
     bool isExecuted() { return m_executed; }
 
 protected:
-    std::function<void()> m_callback;
+    EventCallback m_callback;
     bool m_canceled;
     bool m_executed;
+
+private:
+    static std::atomic<uint64> m_createdCount;
+    static std::atomic<uint64> m_heapAllocationCount;
 };
 
 #endif
@@ -24,39 +24,72 @@
 
 #include <framework/core/clock.h>
 #include "timer.h"
+#include "profiler.h"
+
+#include <algorithm>
 
 EventDispatcher g_dispatcher;
 
 void EventDispatcher::shutdown()
 {
-    while(!m_eventList.empty())
+    // everything left must run before the dispatcher is disabled
+    m_pollBudget = 0;
+    while(std::any_of(m_eventLists.begin(), m_eventLists.end(), [](const std::deque<EventPtr>& eventList) { return !eventList.empty(); }))
         poll();
 
-    while(!m_scheduledEventList.empty()) {
-        ScheduledEventPtr scheduledEvent = m_scheduledEventList.top();
-        scheduledEvent->cancel();
-        m_scheduledEventList.pop();
-    }
+    m_scheduledEvents.clear();
+    m_pollCallbacks.clear();
     m_disabled = true;
+
+    Event::releasePool();
 }
 
 void EventDispatcher::poll()
 {
-    for(int count = 0, max = m_scheduledEventList.size(); count < max && !m_scheduledEventList.empty(); ++count) {
-        ScheduledEventPtr scheduledEvent = m_scheduledEventList.top();
-        if(scheduledEvent->remainingTicks() > 0)
+    const ticks_t startTime = stdext::micros();
+    const ticks_t deadline = m_pollBudget > 0 ? startTime + m_pollBudget : 0;
+
+    for(int count = 0, max = m_scheduledEvents.size(); count < max; ++count) {
+        const ScheduledEventPtr scheduledEvent = m_scheduledEvents.popExpired(g_clock.millis());
+        if(!scheduledEvent)
             break;
-        m_scheduledEventList.pop();
         scheduledEvent->execute();
+        ++m_firedEventCount;
 
         if(scheduledEvent->nextCycle())
-            m_scheduledEventList.push(scheduledEvent);
+            m_scheduledEvents.insert(scheduledEvent);
     }
 
+    // batched updates run before the events list, so events they add are still executed in this poll
+    for(const auto& callback : m_pollCallbacks)
+        callback();
+
+    bool deferred = false;
+    for(int priority = 0; priority < Fw::LastEventPriority; ++priority) {
+        if(!executeEvents(static_cast<Fw::EventPriority>(priority), deadline)) {
+            deferred = true;
+            m_deferredEventCount += m_eventLists[priority].size();
+        }
+    }
+    m_pollingPriority = -1;
+
+    m_lastPollTime = stdext::micros() - startTime;
+    if(m_pollBudget > 0 && (deferred || m_lastPollTime > m_pollBudget)) {
+        ++m_budgetOverrunCount;
+        g_profiler.addInstantMarker("dispatcher budget overrun");
+    }
+}
+
+bool EventDispatcher::executeEvents(Fw::EventPriority priority, ticks_t deadline)
+{
+    std::deque<EventPtr>& eventList = m_eventLists[priority];
+    m_pollingPriority = priority;
+
     // execute events list until all events are out, this is needed because some events can schedule new events that would
     // change the UIWidgets layout, in this case we must execute these new events before we continue rendering,
-    m_pollEventsSize = m_eventList.size();
+    m_pollEventsSize = eventList.size();
     int loops = 0;
+    int executed = 0;
     while(m_pollEventsSize > 0) {
         if(loops > 50) {
             static Timer reportTimer;
@@ -68,50 +101,77 @@ void EventDispatcher::poll()
         }
 
         for(int i = 0; i < m_pollEventsSize; ++i) {
-            EventPtr event = m_eventList.front();
-            m_eventList.pop_front();
+            // at least one event of each class runs every poll, so a busy frame can't starve it
+            if(deadline > 0 && executed > 0 && stdext::micros() >= deadline)
+                return false;
+
+            EventPtr event = eventList.front();
+            eventList.pop_front();
             event->execute();
+            ++executed;
         }
-        m_pollEventsSize = m_eventList.size();
+        m_pollEventsSize = eventList.size();
 
         loops++;
     }
+    return true;
 }
 
-ScheduledEventPtr EventDispatcher::scheduleEvent(const std::function<void()>& callback, int delay)
+ScheduledEventPtr EventDispatcher::scheduleEvent(EventCallback callback, int delay)
 {
     if(m_disabled)
         return ScheduledEventPtr(new ScheduledEvent(nullptr, delay, 1));
 
     assert(delay >= 0);
-    ScheduledEventPtr scheduledEvent(new ScheduledEvent(callback, delay, 1));
-    m_scheduledEventList.push(scheduledEvent);
+    ScheduledEventPtr scheduledEvent(new ScheduledEvent(std::move(callback), delay, 1));
+    m_scheduledEvents.insert(scheduledEvent);
     return scheduledEvent;
 }
 
-ScheduledEventPtr EventDispatcher::cycleEvent(const std::function<void()>& callback, int delay)
+ScheduledEventPtr EventDispatcher::cycleEvent(EventCallback callback, int delay)
 {
     if(m_disabled)
         return ScheduledEventPtr(new ScheduledEvent(nullptr, delay, 0));
 
     assert(delay > 0);
-    ScheduledEventPtr scheduledEvent(new ScheduledEvent(callback, delay, 0));
-    m_scheduledEventList.push(scheduledEvent);
+    ScheduledEventPtr scheduledEvent(new ScheduledEvent(std::move(callback), delay, 0));
+    m_scheduledEvents.insert(scheduledEvent);
     return scheduledEvent;
 }
 
-EventPtr EventDispatcher::addEvent(const std::function<void()>& callback, bool pushFront)
+void EventDispatcher::addPollCallback(const std::function<void()>& callback)
+{
+    if(m_disabled)
+        return;
+
+    m_pollCallbacks.push_back(callback);
+}
+
+EventPtr EventDispatcher::addEvent(EventCallback callback, bool pushFront)
 {
     if(m_disabled)
         return EventPtr(new Event(nullptr));
 
-    EventPtr event(new Event(callback));
+    EventPtr event(new Event(std::move(callback)));
+    std::deque<EventPtr>& eventList = m_eventLists[Fw::UIEventPriority];
     // front pushing is a way to execute an event before others
     if(pushFront) {
-        m_eventList.push_front(event);
+        eventList.push_front(event);
         // the poll event list only grows when pushing into front
-        m_pollEventsSize++;
+        if(m_pollingPriority == Fw::UIEventPriority)
+            m_pollEventsSize++;
     } else
-        m_eventList.push_back(event);
+        eventList.push_back(event);
+    return event;
+}
+
+EventPtr EventDispatcher::addPriorityEvent(EventCallback callback, Fw::EventPriority priority)
+{
+    if(m_disabled)
+        return EventPtr(new Event(nullptr));
+
+    assert(priority >= 0 && priority < Fw::LastEventPriority);
+    EventPtr event(new Event(std::move(callback)));
+    m_eventLists[priority].push_back(event);
     return event;
 }
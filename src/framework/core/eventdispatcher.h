@@ -25,8 +25,8 @@
 
 #include "clock.h"
 #include "scheduledevent.h"
-
-#include <queue>
+#include "timingwheel.h"
+#include <framework/const.h>
 
  // @bindsingleton g_dispatcher
 class EventDispatcher
@@ -35,15 +35,43 @@ public:
     void shutdown();
     void poll();
 
-    EventPtr addEvent(const std::function<void()>& callback, bool pushFront = false);
-    ScheduledEventPtr scheduleEvent(const std::function<void()>& callback, int delay);
-    ScheduledEventPtr cycleEvent(const std::function<void()>& callback, int delay);
+    EventPtr addEvent(EventCallback callback, bool pushFront = false);
+    EventPtr addPriorityEvent(EventCallback callback, Fw::EventPriority priority);
+    ScheduledEventPtr scheduleEvent(EventCallback callback, int delay);
+    ScheduledEventPtr cycleEvent(EventCallback callback, int delay);
+
+    // callbacks run once every poll, for systems that batch their own per frame updates
+    void addPollCallback(const std::function<void()>& callback);
+
+    // when a budget is set events left over once it is spent are deferred to the next poll,
+    // packets are parsed by the network poll before and are never deferred
+    void setPollBudget(int micros) { m_pollBudget = std::max<int>(micros, 0); }
+    int getPollBudget() { return m_pollBudget; }
+    int getLastPollTime() { return m_lastPollTime; }
+    uint64 getBudgetOverrunCount() { return m_budgetOverrunCount; }
+    uint64 getDeferredEventCount() { return m_deferredEventCount; }
+
+    uint32 getLiveEventCount() { return m_scheduledEvents.size(); }
+    uint64 getCancelledEventCount() { return m_scheduledEvents.getRemovedCount(); }
+    uint64 getFiredEventCount() { return m_firedEventCount; }
+    uint64 getCreatedEventCount() { return Event::getCreatedCount(); }
+    uint64 getEventHeapAllocationCount() { return Event::getHeapAllocationCount(); }
+    uint64 getCallbackHeapAllocationCount() { return stdext::inplace_function_heap_allocations.load(); }
 
 private:
-    std::deque<EventPtr> m_eventList;
+    bool executeEvents(Fw::EventPriority priority, ticks_t deadline);
+
+    std::array<std::deque<EventPtr>, Fw::LastEventPriority> m_eventLists;
     int m_pollEventsSize;
+    int m_pollingPriority{ -1 };
+    int m_pollBudget{ 0 };
+    int m_lastPollTime{ 0 };
+    uint64 m_budgetOverrunCount{ 0 };
+    uint64 m_deferredEventCount{ 0 };
     bool m_disabled{ false };
-    std::priority_queue<ScheduledEventPtr, std::deque<ScheduledEventPtr>, ScheduledEvent::Compare> m_scheduledEventList;
+    TimingWheel m_scheduledEvents;
+    std::vector<std::function<void()>> m_pollCallbacks;
+    uint64 m_firedEventCount{ 0 };
 };
 
 extern EventDispatcher g_dispatcher;
@@ -337,7 +337,12 @@ BinaryTreePtr FileStream::getBinaryTree()
     if(byte != BINARYTREE_NODE_START)
         stdext::throw_exception(stdext::format("failed to read node start (getBinaryTree): %d", byte));
 
-    return BinaryTreePtr(new BinaryTree(asFileStream()));
+    if(!m_caching)
+        cache();
+
+    BinaryTreePtr tree(new BinaryTree);
+    m_pos += tree->unserialize(m_data.data() + m_pos, m_data.size() - m_pos);
+    return tree;
 }
 
 void FileStream::startNode(uint8 n)
@@ -23,6 +23,7 @@
 #include "graphicalapplication.h"
 #include <framework/core/clock.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/core/profiler.h>
 #include <framework/platform/platformwindow.h>
 #include <framework/ui/uimanager.h>
 #include <framework/graphics/graphics.h>
@@ -126,6 +127,8 @@ void GraphicalApplication::run()
     g_lua.callGlobalField("g_app", "onRun");
 
     while(!m_stopping) {
+        g_profiler.nextFrame();
+
         // poll all events before rendering
         poll();
 
@@ -186,6 +189,7 @@ void GraphicalApplication::run()
                 }
 
                 // update screen pixels
+                PROFILE_SCOPE("swap buffers");
                 g_window.swapBuffers();
             }
 
@@ -196,10 +200,16 @@ void GraphicalApplication::run()
                 g_lua.callGlobalField("g_app", "onFps", m_backgroundFrameCounter.getLastFps());
             m_foregroundFrameCounter.update();
 
+            // collect lua garbage in the time left for this frame
+            g_lua.stepGarbageCollector(std::max<int>(m_backgroundFrameCounter.getMaximumSleepMicros(), 0));
+            g_clock.update();
+
             const int sleepMicros = m_backgroundFrameCounter.getMaximumSleepMicros();
             if(sleepMicros >= AdaptativeFrameCounter::MINIMUM_MICROS_SLEEP)
                 stdext::microsleep(sleepMicros);
         } else {
+            g_lua.stepGarbageCollector(g_lua.getGarbageCollectorMaxStepTime());
+
             // sleeps until next poll to avoid massive cpu usage
             stdext::millisleep(POLL_CYCLE_DELAY + 1);
             g_clock.update();
@@ -212,12 +222,17 @@ void GraphicalApplication::run()
 
 void GraphicalApplication::poll()
 {
+    PROFILE_SCOPE("poll");
+
 #ifdef FW_SOUND
     g_sounds.poll();
 #endif
 
     // poll window input events
-    g_window.poll();
+    {
+        PROFILE_SCOPE("window poll");
+        g_window.poll();
+    }
     g_particles.poll();
     g_textures.poll();
 
@@ -49,7 +49,7 @@ void Logger::log(Fw::LogLevel level, const std::string& message)
         return;
 #endif
 
-    if(s_ignoreLogs)
+    if(s_ignoreLogs || level < m_level)
         return;
 
     std::string outmsg = s_logPrefixes[level] + message;
@@ -84,10 +84,10 @@ void Logger::log(Fw::LogLevel level, const std::string& message)
 
     if(m_onLog) {
         // schedule log callback, because this callback can run lua code that may affect the current state
-        g_dispatcher.addEvent([=] {
+        g_dispatcher.addPriorityEvent([=] {
             if(m_onLog)
                 m_onLog(level, outmsg, now);
-        });
+        }, Fw::BackgroundEventPriority);
     }
 
     if(level == Fw::LogFatal) {
@@ -26,6 +26,7 @@
 #include "../global.h"
 
 #include <framework/stdext/thread.h>
+#include <atomic>
 #include <fstream>
 #include <utility>
 
@@ -58,10 +59,14 @@ public:
     void fireOldMessages();
     void setLogFile(const std::string& file);
     void setOnLog(const OnLogCallback& onLog) { m_onLog = onLog; }
+    void setLevel(Fw::LogLevel level) { m_level = level; }
+    Fw::LogLevel getLevel() { return static_cast<Fw::LogLevel>(m_level.load()); }
 
 private:
     std::deque<LogMessage> m_logMessages;
     OnLogCallback m_onLog;
+    // read by the workers before they hand a message over
+    std::atomic<int> m_level{ Fw::LogDebug };
     std::ofstream m_outFile;
     std::recursive_mutex m_mutex;
 };
@@ -60,6 +60,8 @@ bool Module::load()
                 stdext::throw_exception(stdext::format("dependency '%s' has failed to load", depName));
         }
 
+        // dependencies are timed on their own
+        stdext::timer loadTimer;
         if(m_sandboxed)
             g_lua.setGlobalEnvironment(m_sandboxEnv);
 
@@ -83,7 +85,8 @@ bool Module::load()
             g_lua.resetGlobalEnvironment();
 
         m_loaded = true;
-        g_logger.debug(stdext::format("Loaded module '%s'", m_name));
+        m_loadTime = loadTimer.elapsed_micros();
+        g_logger.debug(stdext::format("Loaded module '%s' (%.2fms)", m_name, m_loadTime / 1000.0));
     } catch(stdext::exception& e) {
         // remove from package.loaded
         g_lua.getGlobalField("package", "loaded");
@@ -197,6 +200,7 @@ void Module::discover(const OTMLNodePtr& moduleNode)
     m_reloadable = moduleNode->valueAt<bool>("reloadable", true);
     m_sandboxed = moduleNode->valueAt<bool>("sandboxed", false);
     m_autoLoadPriority = moduleNode->valueAt<int>("autoload-priority", 9999);
+    m_path = moduleNode->source().substr(0, moduleNode->source().rfind('/'));
 
     if(OTMLNodePtr node = moduleNode->get("dependencies")) {
         for(const OTMLNodePtr& tmp : node->children())
@@ -52,8 +52,12 @@ public:
     std::string getAuthor() { return m_author; }
     std::string getWebsite() { return m_website; }
     std::string getVersion() { return m_version; }
+    // directory of the module's otmod file
+    std::string getPath() { return m_path; }
     bool isAutoLoad() { return m_autoLoad; }
     int getAutoLoadPriority() { return m_autoLoadPriority; }
+    // time spent running the module's own scripts on its last load, in microseconds
+    ticks_t getLoadTime() { return m_loadTime; }
 
     // @dontbind
     ModulePtr asModule() { return static_self_cast<Module>(); }
@@ -70,6 +74,7 @@ private:
 
     int m_autoLoadPriority;
     int m_sandboxEnv;
+    ticks_t m_loadTime{ 0 };
     std::tuple<std::string, std::string> m_onLoadFunc;
     std::tuple<std::string, std::string> m_onUnloadFunc;
     std::string m_name;
@@ -77,6 +82,7 @@ private:
     std::string m_author;
     std::string m_website;
     std::string m_version;
+    std::string m_path;
     std::function<void()> m_loadCallback;
     std::function<void()> m_unloadCallback;
     std::list<std::string> m_dependencies;
@@ -54,13 +54,19 @@ void ModuleManager::discoverModules()
 
 void ModuleManager::autoLoadModules(int maxPriority)
 {
+    stdext::timer loadTimer;
+    int loaded = 0;
     for(auto& pair : m_autoLoadModules) {
         const int priority = pair.first;
         if(priority > maxPriority)
             break;
         ModulePtr module = pair.second;
-        module->load();
+        if(!module->isLoaded() && module->load())
+            ++loaded;
     }
+
+    if(loaded > 0)
+        g_logger.debug(stdext::format("Loaded %d modules up to priority %d in %.2fms", loaded, maxPriority, loadTimer.elapsed_micros() / 1000.0));
 }
 
 ModulePtr ModuleManager::discoverModule(const std::string& moduleFile)
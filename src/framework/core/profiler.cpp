@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "profiler.h"
+
+#include <framework/core/resourcemanager.h>
+
+#include <sstream>
+
+Profiler g_profiler;
+
+Profiler::Profiler() : m_mainThreadId(std::this_thread::get_id())
+{
+}
+
+void Profiler::nextFrame()
+{
+    if(!isEnabled())
+        return;
+
+    m_frames[m_frameCount % FRAME_HISTORY] = stdext::micros();
+    ++m_frameCount;
+    addInstantMarker("frame");
+}
+
+void Profiler::addMarker(const char* name, ticks_t begin, ticks_t end)
+{
+    writeMarker(name, begin, end - begin);
+}
+
+void Profiler::addInstantMarker(const char* name)
+{
+    if(!isEnabled())
+        return;
+
+    writeMarker(name, stdext::micros(), -1);
+}
+
+bool Profiler::dumpTrace(const std::string& fileName, int frames)
+{
+    // markers older than the first requested frame are left out
+    ticks_t since = 0;
+    if(frames > 0 && m_frameCount > 0) {
+        const uint32 first = m_frameCount - std::min<uint32>({ static_cast<uint32>(frames), m_frameCount, FRAME_HISTORY });
+        since = m_frames[first % FRAME_HISTORY];
+    }
+
+    std::stringstream ss;
+    ss << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool first = true;
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+    for(uint32 tid = 0; tid < m_buffers.size(); ++tid) {
+        ThreadBuffer& buffer = *m_buffers[tid];
+        if(!first)
+            ss << ",";
+        first = false;
+        ss << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":\"" << buffer.name << "\"}}";
+
+        const uint32 head = buffer.head.load(std::memory_order_acquire);
+        const uint32 count = std::min<uint32>(head, BUFFER_SIZE);
+        for(uint32 i = head - count; i != head; ++i) {
+            const Marker& marker = buffer.markers[i % BUFFER_SIZE];
+            const char* name = marker.name.load(std::memory_order_relaxed);
+            const ticks_t begin = marker.begin.load(std::memory_order_relaxed);
+            const int32 duration = marker.duration.load(std::memory_order_relaxed);
+
+            // the owner thread keeps writing while the buffer is read, skip slots it may have started to overwrite
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(buffer.head.load(std::memory_order_relaxed) - i >= BUFFER_SIZE)
+                continue;
+
+            if(!name || begin < since)
+                continue;
+
+            ss << ",{\"name\":\"" << name << "\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << begin;
+            if(duration < 0)
+                ss << ",\"ph\":\"i\",\"s\":\"t\"}";
+            else
+                ss << ",\"ph\":\"X\",\"dur\":" << duration << "}";
+        }
+    }
+    ss << "]}";
+
+    return g_resources.writeFileContents(fileName, ss.str());
+}
+
+Profiler::ThreadBuffer* Profiler::getThreadBuffer()
+{
+    static thread_local ThreadBuffer* currentBuffer = nullptr;
+    if(currentBuffer)
+        return currentBuffer;
+
+    // buffers are allocated on the first marker of each thread and live as long as the profiler
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+    auto buffer = std::make_unique<ThreadBuffer>();
+    if(std::this_thread::get_id() == m_mainThreadId)
+        buffer->name = "main";
+    else
+        buffer->name = stdext::format("worker %d", m_buffers.size());
+    currentBuffer = buffer.get();
+    m_buffers.push_back(std::move(buffer));
+    return currentBuffer;
+}
+
+void Profiler::writeMarker(const char* name, ticks_t begin, int32 duration)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+    const uint32 head = buffer->head.load(std::memory_order_relaxed);
+    Marker& marker = buffer->markers[head % BUFFER_SIZE];
+    marker.name.store(name, std::memory_order_relaxed);
+    marker.begin.store(begin, std::memory_order_relaxed);
+    marker.duration.store(duration, std::memory_order_relaxed);
+    buffer->head.store(head + 1, std::memory_order_release);
+}
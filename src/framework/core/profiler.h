@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "declarations.h"
+#include <framework/stdext/time.h>
+#include <framework/stdext/thread.h>
+
+#include <atomic>
+
+// Records timing markers of the main loop and worker threads into per thread ring buffers,
+// only the owning thread writes into a buffer so recording never takes a lock.
+// @bindsingleton g_profiler
+class Profiler
+{
+public:
+    enum {
+        BUFFER_SIZE = 16384,
+        FRAME_HISTORY = 1024
+    };
+
+    Profiler();
+
+    void setEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+    bool isEnabled() { return m_enabled.load(std::memory_order_relaxed); }
+
+    void nextFrame();
+    void addMarker(const char* name, ticks_t begin, ticks_t end);
+    void addInstantMarker(const char* name);
+
+    // writes the markers of the last frames as chrome trace events json, viewable in chrome://tracing
+    bool dumpTrace(const std::string& fileName, int frames);
+
+    uint32 getFrameCount() { return m_frameCount; }
+
+private:
+    struct Marker {
+        std::atomic<const char*> name{ nullptr };
+        std::atomic<ticks_t> begin{ 0 };
+        // -1 for instant markers
+        std::atomic<int32> duration{ 0 };
+    };
+
+    struct ThreadBuffer {
+        std::string name;
+        std::atomic<uint32> head{ 0 };
+        std::array<Marker, BUFFER_SIZE> markers;
+    };
+
+    ThreadBuffer* getThreadBuffer();
+    void writeMarker(const char* name, ticks_t begin, int32 duration);
+
+    std::atomic<bool> m_enabled{ false };
+    std::thread::id m_mainThreadId;
+    std::mutex m_buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    std::array<ticks_t, FRAME_HISTORY> m_frames;
+    uint32 m_frameCount{ 0 };
+};
+
+extern Profiler g_profiler;
+
+// times the enclosing scope, name must be a string literal
+class ProfileScope
+{
+public:
+    ProfileScope(const char* name) : m_name(name), m_begin(g_profiler.isEnabled() ? stdext::micros() : 0) {}
+    ~ProfileScope()
+    {
+        if(m_begin != 0)
+            g_profiler.addMarker(m_name, m_begin, stdext::micros());
+    }
+
+private:
+    const char* m_name;
+    ticks_t m_begin;
+};
+
+#define PROFILE_SCOPE_CONCAT(a, b) a ## b
+#define PROFILE_SCOPE_NAME(line) PROFILE_SCOPE_CONCAT(profileScope, line)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_SCOPE_NAME(__LINE__)(name)
+
+#endif
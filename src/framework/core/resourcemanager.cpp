@@ -22,6 +22,7 @@
 
 #include "resourcemanager.h"
 #include "filestream.h"
+#include "resourcepackage.h"
 
 #include <framework/core/application.h>
 #include <framework/luaengine/luainterface.h>
@@ -31,14 +32,41 @@
 
 ResourceManager g_resources;
 
+namespace
+{
+#pragma pack(push,1)
+    struct CacheHeader
+    {
+        uint32 signature;
+        uint32 version;
+        int64 sourceTime;
+        uint32 sourceSize;
+        uint32 sourceHash;
+    };
+#pragma pack(pop)
+
+    CacheHeader makeCacheHeader(uint32 signature, uint32 version, const std::string& sourceFile, const std::string& sourceBuffer)
+    {
+        CacheHeader header;
+        header.signature = signature;
+        header.version = version;
+        header.sourceTime = g_resources.getFileTime(sourceFile);
+        header.sourceSize = sourceBuffer.size();
+        header.sourceHash = stdext::adler32(reinterpret_cast<const uint8_t*>(sourceBuffer.data()), sourceBuffer.size());
+        return header;
+    }
+}
+
 void ResourceManager::init(const char* argv0)
 {
     PHYSFS_init(argv0);
     PHYSFS_permitSymbolicLinks(1);
+    ResourcePackage::registerArchiver();
 }
 
 void ResourceManager::terminate()
 {
+    clearPathCache();
     PHYSFS_deinit();
 }
 
@@ -58,6 +86,7 @@ bool ResourceManager::discoverWorkDir(const std::string& existentFile)
         if(PHYSFS_exists(existentFile.c_str())) {
             g_logger.debug(stdext::format("Found work dir at '%s'", dir));
             m_workDir = dir;
+            clearPathCache();
             found = true;
             break;
         }
@@ -128,6 +157,7 @@ bool ResourceManager::addSearchPath(const std::string& path, bool pushFront)
         m_searchPaths.push_front(savePath);
     else
         m_searchPaths.push_back(savePath);
+    clearPathCache();
     return true;
 }
 
@@ -138,6 +168,7 @@ bool ResourceManager::removeSearchPath(const std::string& path)
     const auto it = std::find(m_searchPaths.begin(), m_searchPaths.end(), path);
     assert(it != m_searchPaths.end());
     m_searchPaths.erase(it);
+    clearPathCache();
     return true;
 }
 
@@ -154,19 +185,21 @@ void ResourceManager::searchAndAddPackages(const std::string& packagesDir, const
     }
 }
 
+bool ResourceManager::createPackage(const std::string& packageFile, const std::string& directory, bool compress)
+{
+    return ResourcePackage::create(packageFile, directory, compress);
+}
+
 bool ResourceManager::fileExists(const std::string& fileName)
 {
-    return (PHYSFS_exists(resolvePath(fileName).c_str()) && !directoryExists(fileName));
+    const PathInfo info = getPathInfo(resolvePath(fileName));
+    return info.exists && !info.directory;
 }
 
 bool ResourceManager::directoryExists(const std::string& directoryName)
 {
-    PHYSFS_Stat stat = {};
-    if(!PHYSFS_stat(resolvePath(directoryName).c_str(), &stat)) {
-        return false;
-    }
-
-    return stat.filetype == PHYSFS_FILETYPE_DIRECTORY;
+    const PathInfo info = getPathInfo(resolvePath(directoryName));
+    return info.exists && info.directory;
 }
 
 void ResourceManager::readFileStream(const std::string& fileName, std::iostream& out)
@@ -204,6 +237,7 @@ bool ResourceManager::writeFileBuffer(const std::string& fileName, const uchar*
         g_logger.error(PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
         return false;
     }
+    clearPathCache();
 
     PHYSFS_writeBytes(file, data, size);
     PHYSFS_close(file);
@@ -243,6 +277,7 @@ FileStreamPtr ResourceManager::appendFile(const std::string& fileName)
     PHYSFS_File* file = PHYSFS_openAppend(fileName.c_str());
     if(!file)
         stdext::throw_exception(stdext::format("failed to append file '%s': %s", fileName, PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode())));
+    clearPathCache();
     return FileStreamPtr(new FileStream(fileName, file, true));
 }
 
@@ -251,17 +286,22 @@ FileStreamPtr ResourceManager::createFile(const std::string& fileName)
     PHYSFS_File* file = PHYSFS_openWrite(fileName.c_str());
     if(!file)
         stdext::throw_exception(stdext::format("failed to create file '%s': %s", fileName, PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode())));
+    clearPathCache();
     return FileStreamPtr(new FileStream(fileName, file, true));
 }
 
 bool ResourceManager::deleteFile(const std::string& fileName)
 {
-    return PHYSFS_delete(resolvePath(fileName).c_str()) != 0;
+    const bool ret = PHYSFS_delete(resolvePath(fileName).c_str()) != 0;
+    clearPathCache();
+    return ret;
 }
 
 bool ResourceManager::makeDir(const std::string& directory)
 {
-    return PHYSFS_mkdir(directory.c_str());
+    const bool ret = PHYSFS_mkdir(directory.c_str());
+    clearPathCache();
+    return ret;
 }
 
 std::list<std::string> ResourceManager::listDirectoryFiles(const std::string& directoryPath)
@@ -309,6 +349,10 @@ std::vector<std::string> ResourceManager::discoverPath(const fs::path& path, boo
 
 std::string ResourceManager::resolvePath(const std::string& path)
 {
+    // most lookups are already resolved
+    if(stdext::starts_with(path, "/") && path.find("//") == std::string::npos)
+        return path;
+
     std::string fullPath;
     if(stdext::starts_with(path, "/"))
         fullPath = path;
@@ -326,11 +370,7 @@ std::string ResourceManager::resolvePath(const std::string& path)
 
 std::string ResourceManager::getRealDir(const std::string& path)
 {
-    std::string dir;
-    const char* cdir = PHYSFS_getRealDir(resolvePath(path).c_str());
-    if(cdir)
-        dir = cdir;
-    return dir;
+    return getPathInfo(resolvePath(path)).realDir;
 }
 
 std::string ResourceManager::getRealPath(const std::string& path)
@@ -366,3 +406,60 @@ ticks_t ResourceManager::getFileTime(const std::string& filename)
 {
     return g_platform.getFileModificationTime(getRealPath(filename));
 }
+
+ResourceManager::PathInfo ResourceManager::getPathInfo(const std::string& fullPath)
+{
+    std::lock_guard<std::mutex> lock(m_pathCacheMutex);
+    const auto it = m_pathCache.find(fullPath);
+    if(it != m_pathCache.end())
+        return it->second;
+
+    PathInfo info;
+    PHYSFS_Stat stat = {};
+    info.exists = PHYSFS_stat(fullPath.c_str(), &stat) != 0;
+    info.directory = info.exists && stat.filetype == PHYSFS_FILETYPE_DIRECTORY;
+    if(info.exists) {
+        if(const char* realDir = PHYSFS_getRealDir(fullPath.c_str()))
+            info.realDir = realDir;
+        m_pathCache.emplace(fullPath, info);
+    }
+    return info;
+}
+
+void ResourceManager::clearPathCache()
+{
+    std::lock_guard<std::mutex> lock(m_pathCacheMutex);
+    m_pathCache.clear();
+}
+
+bool ResourceManager::readCacheFile(const std::string& cacheFile, uint32 signature, uint32 version, const std::string& sourceFile, const std::string& sourceBuffer, std::string& data)
+{
+    if(!fileExists(cacheFile))
+        return false;
+
+    try {
+        data = readFileContents(cacheFile);
+    } catch(stdext::exception&) {
+        return false;
+    }
+
+    const CacheHeader header = makeCacheHeader(signature, version, sourceFile, sourceBuffer);
+    if(data.size() < sizeof(CacheHeader) || memcmp(data.data(), &header, sizeof(CacheHeader)) != 0)
+        return false;
+
+    data.erase(0, sizeof(CacheHeader));
+    return true;
+}
+
+bool ResourceManager::writeCacheFile(const std::string& cacheFile, uint32 signature, uint32 version, const std::string& sourceFile, const std::string& sourceBuffer, const std::string& data)
+{
+    if(m_writeDir.empty())
+        return false;
+
+    const CacheHeader header = makeCacheHeader(signature, version, sourceFile, sourceBuffer);
+    std::string buffer(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+    buffer += data;
+
+    makeDir(cacheFile.substr(0, cacheFile.find_last_of('/')));
+    return writeFileBuffer(cacheFile, reinterpret_cast<const uchar*>(buffer.data()), buffer.size());
+}
@@ -26,6 +26,7 @@
 #include "declarations.h"
 
 #include <boost/filesystem.hpp>
+#include <mutex>
 
 namespace fs = boost::filesystem;
 
@@ -45,6 +46,7 @@ public:
     bool addSearchPath(const std::string& path, bool pushFront = false);
     bool removeSearchPath(const std::string& path);
     void searchAndAddPackages(const std::string& packagesDir, const std::string& packageExt);
+    bool createPackage(const std::string& packageFile, const std::string& directory, bool compress);
 
     bool fileExists(const std::string& fileName);
     bool directoryExists(const std::string& directoryName);
@@ -80,13 +82,32 @@ public:
     bool isFileType(const std::string& filename, const std::string& type);
     ticks_t getFileTime(const std::string& filename);
 
+    // files derived from a source file and kept in the write dir, valid while the source is unchanged
+    bool readCacheFile(const std::string& cacheFile, uint32 signature, uint32 version, const std::string& sourceFile, const std::string& sourceBuffer, std::string& data);
+    bool writeCacheFile(const std::string& cacheFile, uint32 signature, uint32 version, const std::string& sourceFile, const std::string& sourceBuffer, const std::string& data);
+
+    // for files changed behind the resource manager
+    void clearPathCache();
+
 protected:
     std::vector<std::string> discoverPath(const fs::path& path, bool filenameOnly, bool recursive);
 
 private:
+    struct PathInfo
+    {
+        bool exists;
+        bool directory;
+        std::string realDir;
+    };
+
+    // only existing paths are cached
+    PathInfo getPathInfo(const std::string& fullPath);
+
     std::string m_workDir;
     std::string m_writeDir;
     std::deque<std::string> m_searchPaths;
+    std::unordered_map<std::string, PathInfo> m_pathCache;
+    std::mutex m_pathCacheMutex;
 };
 
 extern ResourceManager g_resources;
@@ -0,0 +1,463 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "resourcepackage.h"
+#include "resourcemanager.h"
+#include "filestream.h"
+
+#include <physfs.h>
+#include <zlib.h>
+
+namespace
+{
+    constexpr uint32 PACKAGE_SIGNATURE = 0x4B50544F; // "OTPK"
+    constexpr uint32 PACKAGE_VERSION = 1;
+    constexpr uint32 PACKAGE_HEADER_SIZE = 8;
+    constexpr uint32 PACKAGE_FOOTER_SIZE = 12;
+    constexpr uint32 PACKAGE_ENTRY_SIZE = 13;
+
+    enum PackageEntryFlags : uint8
+    {
+        PackageEntryCompressed = 1 << 0
+    };
+
+    struct PackageEntry
+    {
+        uint32 offset;
+        uint32 size;
+        uint32 rawSize;
+        bool compressed;
+    };
+
+    struct Package
+    {
+        PHYSFS_Io* io;
+        std::unordered_map<std::string, PackageEntry> entries;
+        std::unordered_map<std::string, std::vector<std::string>> directories;
+    };
+
+    struct PackageFile
+    {
+        // duplicate of the package io for plain entries
+        PHYSFS_Io* io{ nullptr };
+        // inflated contents of compressed entries
+        std::shared_ptr<const std::string> data;
+        PackageEntry entry;
+        uint32 pos{ 0 };
+    };
+
+    bool readExactly(PHYSFS_Io* io, void* buffer, PHYSFS_uint64 size)
+    {
+        return io->read(io, buffer, size) == static_cast<PHYSFS_sint64>(size);
+    }
+
+    void addToDirectory(Package& package, const std::string& path)
+    {
+        const auto slash = path.find_last_of('/');
+        const std::string dir = slash == std::string::npos ? "" : path.substr(0, slash);
+        if(!dir.empty() && package.directories.find(dir) == package.directories.end())
+            addToDirectory(package, dir);
+        package.directories[dir].push_back(path.substr(slash + 1));
+    }
+
+    PHYSFS_Io* createFileIo(PackageFile* file);
+
+    PHYSFS_sint64 readPackageFile(PHYSFS_Io* io, void* buffer, PHYSFS_uint64 len)
+    {
+        auto* file = static_cast<PackageFile*>(io->opaque);
+        len = std::min<PHYSFS_uint64>(len, file->entry.rawSize - file->pos);
+        if(len == 0)
+            return 0;
+
+        if(file->data)
+            memcpy(buffer, file->data->data() + file->pos, len);
+        else {
+            const PHYSFS_sint64 read = file->io->read(file->io, buffer, len);
+            if(read <= 0)
+                return read;
+            len = read;
+        }
+        file->pos += len;
+        return len;
+    }
+
+    PHYSFS_sint64 writePackageFile(PHYSFS_Io*, const void*, PHYSFS_uint64)
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_READ_ONLY);
+        return -1;
+    }
+
+    int seekPackageFile(PHYSFS_Io* io, PHYSFS_uint64 offset)
+    {
+        auto* file = static_cast<PackageFile*>(io->opaque);
+        if(offset > file->entry.rawSize) {
+            PHYSFS_setErrorCode(PHYSFS_ERR_PAST_EOF);
+            return 0;
+        }
+        if(file->io && !file->io->seek(file->io, file->entry.offset + offset))
+            return 0;
+        file->pos = offset;
+        return 1;
+    }
+
+    PHYSFS_sint64 tellPackageFile(PHYSFS_Io* io)
+    {
+        return static_cast<PackageFile*>(io->opaque)->pos;
+    }
+
+    PHYSFS_sint64 lengthPackageFile(PHYSFS_Io* io)
+    {
+        return static_cast<PackageFile*>(io->opaque)->entry.rawSize;
+    }
+
+    PHYSFS_Io* duplicatePackageFile(PHYSFS_Io* io)
+    {
+        const auto* file = static_cast<PackageFile*>(io->opaque);
+        auto* copy = new PackageFile(*file);
+        if(file->io) {
+            copy->io = file->io->duplicate(file->io);
+            if(!copy->io || !copy->io->seek(copy->io, file->entry.offset + file->pos)) {
+                if(copy->io)
+                    copy->io->destroy(copy->io);
+                delete copy;
+                return nullptr;
+            }
+        }
+        return createFileIo(copy);
+    }
+
+    int flushPackageFile(PHYSFS_Io*)
+    {
+        return 1;
+    }
+
+    void destroyPackageFile(PHYSFS_Io* io)
+    {
+        auto* file = static_cast<PackageFile*>(io->opaque);
+        if(file->io)
+            file->io->destroy(file->io);
+        delete file;
+        delete io;
+    }
+
+    PHYSFS_Io* createFileIo(PackageFile* file)
+    {
+        return new PHYSFS_Io{ 0, file, readPackageFile, writePackageFile, seekPackageFile, tellPackageFile,
+                              lengthPackageFile, duplicatePackageFile, flushPackageFile, destroyPackageFile };
+    }
+
+    void* openPackage(PHYSFS_Io* io, const char*, int forWrite, int* claimed)
+    {
+        uint8 header[PACKAGE_HEADER_SIZE];
+        if(!io->seek(io, 0) || !readExactly(io, header, PACKAGE_HEADER_SIZE) || stdext::readULE32(header) != PACKAGE_SIGNATURE) {
+            PHYSFS_setErrorCode(PHYSFS_ERR_UNSUPPORTED);
+            return nullptr;
+        }
+
+        *claimed = 1;
+        if(forWrite) {
+            PHYSFS_setErrorCode(PHYSFS_ERR_READ_ONLY);
+            return nullptr;
+        }
+        if(stdext::readULE32(header + 4) != PACKAGE_VERSION) {
+            PHYSFS_setErrorCode(PHYSFS_ERR_UNSUPPORTED);
+            return nullptr;
+        }
+
+        uint8 footer[PACKAGE_FOOTER_SIZE];
+        const PHYSFS_sint64 length = io->length(io);
+        if(length < PACKAGE_HEADER_SIZE + PACKAGE_FOOTER_SIZE || length > std::numeric_limits<uint32>::max() ||
+           !io->seek(io, length - PACKAGE_FOOTER_SIZE) || !readExactly(io, footer, PACKAGE_FOOTER_SIZE) ||
+           stdext::readULE32(footer + 8) != PACKAGE_SIGNATURE) {
+            PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+            return nullptr;
+        }
+
+        const uint32 count = stdext::readULE32(footer);
+        const uint32 indexOffset = stdext::readULE32(footer + 4);
+        const uint32 indexEnd = length - PACKAGE_FOOTER_SIZE;
+        if(indexOffset < PACKAGE_HEADER_SIZE || indexOffset > indexEnd) {
+            PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+            return nullptr;
+        }
+
+        std::vector<uint8> index(indexEnd - indexOffset);
+        if(!io->seek(io, indexOffset) || !readExactly(io, index.data(), index.size())) {
+            PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+            return nullptr;
+        }
+
+        auto package = std::make_unique<Package>();
+        package->directories[""];
+        package->entries.reserve(count);
+
+        size_t pos = 0;
+        for(uint32 i = 0; i < count; ++i) {
+            if(pos + 2 > index.size()) {
+                PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+                return nullptr;
+            }
+            const uint16 pathLength = stdext::readULE16(&index[pos]);
+            pos += 2;
+            if(pathLength == 0 || pos + pathLength + PACKAGE_ENTRY_SIZE > index.size()) {
+                PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+                return nullptr;
+            }
+
+            std::string path(reinterpret_cast<const char*>(&index[pos]), pathLength);
+            pos += pathLength;
+
+            PackageEntry entry;
+            entry.compressed = index[pos] & PackageEntryCompressed;
+            entry.offset = stdext::readULE32(&index[pos + 1]);
+            entry.size = stdext::readULE32(&index[pos + 5]);
+            entry.rawSize = stdext::readULE32(&index[pos + 9]);
+            pos += PACKAGE_ENTRY_SIZE;
+
+            if(entry.offset < PACKAGE_HEADER_SIZE || entry.size > indexOffset - entry.offset ||
+               (!entry.compressed && entry.size != entry.rawSize) ||
+               package->directories.find(path) != package->directories.end() ||
+               !package->entries.emplace(path, entry).second) {
+                PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+                return nullptr;
+            }
+            addToDirectory(*package, path);
+        }
+
+        package->io = io;
+        return package.release();
+    }
+
+    PHYSFS_EnumerateCallbackResult enumeratePackage(void* opaque, const char* dirname, PHYSFS_EnumerateCallback callback,
+                                                    const char* origdir, void* callbackdata)
+    {
+        const auto* package = static_cast<Package*>(opaque);
+        const auto it = package->directories.find(dirname);
+        if(it == package->directories.end()) {
+            PHYSFS_setErrorCode(PHYSFS_ERR_NOT_FOUND);
+            return PHYSFS_ENUM_ERROR;
+        }
+
+        for(const std::string& name : it->second) {
+            const PHYSFS_EnumerateCallbackResult ret = callback(callbackdata, origdir, name.c_str());
+            if(ret == PHYSFS_ENUM_ERROR) {
+                PHYSFS_setErrorCode(PHYSFS_ERR_APP_CALLBACK);
+                return PHYSFS_ENUM_ERROR;
+            }
+            if(ret == PHYSFS_ENUM_STOP)
+                return PHYSFS_ENUM_STOP;
+        }
+        return PHYSFS_ENUM_OK;
+    }
+
+    PHYSFS_Io* openPackageFile(void* opaque, const char* name)
+    {
+        const auto* package = static_cast<Package*>(opaque);
+        const auto it = package->entries.find(name);
+        if(it == package->entries.end()) {
+            const bool directory = package->directories.find(name) != package->directories.end();
+            PHYSFS_setErrorCode(directory ? PHYSFS_ERR_NOT_A_FILE : PHYSFS_ERR_NOT_FOUND);
+            return nullptr;
+        }
+
+        auto file = std::make_unique<PackageFile>();
+        file->entry = it->second;
+
+        PHYSFS_Io* io = package->io;
+        if(file->entry.compressed) {
+            std::vector<uint8> compressed(file->entry.size);
+            auto data = std::make_shared<std::string>(file->entry.rawSize, '\0');
+            uLongf len = file->entry.rawSize;
+            if(!io->seek(io, file->entry.offset) || !readExactly(io, compressed.data(), compressed.size()) ||
+               uncompress(reinterpret_cast<uchar*>(&(*data)[0]), &len, compressed.data(), compressed.size()) != Z_OK ||
+               len != file->entry.rawSize) {
+                PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+                return nullptr;
+            }
+            file->data = data;
+        } else {
+            file->io = io->duplicate(io);
+            if(!file->io)
+                return nullptr;
+            if(!file->io->seek(file->io, file->entry.offset)) {
+                file->io->destroy(file->io);
+                return nullptr;
+            }
+        }
+        return createFileIo(file.release());
+    }
+
+    PHYSFS_Io* openPackageForWrite(void*, const char*)
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_READ_ONLY);
+        return nullptr;
+    }
+
+    int modifyPackage(void*, const char*)
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_READ_ONLY);
+        return 0;
+    }
+
+    int statPackage(void* opaque, const char* name, PHYSFS_Stat* stat)
+    {
+        const auto* package = static_cast<Package*>(opaque);
+        const auto it = package->entries.find(name);
+        if(it != package->entries.end()) {
+            stat->filesize = it->second.rawSize;
+            stat->filetype = PHYSFS_FILETYPE_REGULAR;
+        } else if(package->directories.find(name) != package->directories.end()) {
+            stat->filesize = 0;
+            stat->filetype = PHYSFS_FILETYPE_DIRECTORY;
+        } else {
+            PHYSFS_setErrorCode(PHYSFS_ERR_NOT_FOUND);
+            return 0;
+        }
+        stat->modtime = -1;
+        stat->createtime = -1;
+        stat->accesstime = -1;
+        stat->readonly = 1;
+        return 1;
+    }
+
+    void closePackage(void* opaque)
+    {
+        auto* package = static_cast<Package*>(opaque);
+        package->io->destroy(package->io);
+        delete package;
+    }
+
+    const PHYSFS_Archiver PackageArchiver = {
+        0,
+        { "otpkg", "OTClient indexed package", "OTClient", "https://github.com/edubart/otclient", 0 },
+        openPackage,
+        enumeratePackage,
+        openPackageFile,
+        openPackageForWrite,
+        openPackageForWrite,
+        modifyPackage,
+        modifyPackage,
+        statPackage,
+        closePackage
+    };
+
+    void collectFiles(const std::string& root, const std::string& dir, std::vector<std::string>& files)
+    {
+        for(const std::string& name : g_resources.listDirectoryFiles(root + "/" + dir)) {
+            const std::string path = dir.empty() ? name : dir + "/" + name;
+            if(g_resources.directoryExists(root + "/" + path))
+                collectFiles(root, path, files);
+            else
+                files.push_back(path);
+        }
+    }
+}
+
+bool ResourcePackage::registerArchiver()
+{
+    if(!PHYSFS_registerArchiver(&PackageArchiver)) {
+        g_logger.error(stdext::format("Unable to register package archiver: %s", PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode())));
+        return false;
+    }
+    return true;
+}
+
+bool ResourcePackage::create(const std::string& packageFile, const std::string& directory, bool compress)
+{
+    const int COMPRESS_LEVEL = 6;
+
+    try {
+        const std::string root = g_resources.resolvePath(directory);
+        const std::string packagePath = g_resources.resolvePath(packageFile);
+
+        std::vector<std::string> files;
+        collectFiles(root, "", files);
+
+        struct WrittenEntry
+        {
+            std::string path;
+            PackageEntry entry;
+        };
+        std::vector<WrittenEntry> entries;
+        entries.reserve(files.size());
+
+        const FileStreamPtr fout = g_resources.createFile(packagePath);
+        fout->addU32(PACKAGE_SIGNATURE);
+        fout->addU32(PACKAGE_VERSION);
+
+        uint64 offset = PACKAGE_HEADER_SIZE;
+        std::vector<uint8> compressBuffer;
+        for(const std::string& path : files) {
+            if(g_resources.resolvePath(root + "/" + path) == packagePath)
+                continue;
+            if(path.size() > std::numeric_limits<uint16>::max())
+                stdext::throw_exception(stdext::format("path '%s' is too long", path));
+
+            const std::string data = g_resources.readFileContents(root + "/" + path);
+
+            PackageEntry entry;
+            entry.offset = offset;
+            entry.rawSize = data.size();
+            entry.size = data.size();
+            entry.compressed = false;
+
+            const uint8* payload = reinterpret_cast<const uint8*>(data.data());
+            if(compress && !data.empty()) {
+                uLongf len = compressBound(data.size());
+                compressBuffer.resize(len);
+                if(compress2(compressBuffer.data(), &len, payload, data.size(), COMPRESS_LEVEL) == Z_OK && len < data.size()) {
+                    payload = compressBuffer.data();
+                    entry.size = len;
+                    entry.compressed = true;
+                }
+            }
+
+            offset += entry.size;
+            if(offset > std::numeric_limits<uint32>::max())
+                stdext::throw_exception("package is larger than 4GB");
+
+            fout->write(payload, entry.size);
+            entries.push_back({ path, entry });
+        }
+
+        for(const WrittenEntry& written : entries) {
+            fout->addU16(written.path.size());
+            fout->write(written.path.data(), written.path.size());
+            fout->addU8(written.entry.compressed ? PackageEntryCompressed : 0);
+            fout->addU32(written.entry.offset);
+            fout->addU32(written.entry.size);
+            fout->addU32(written.entry.rawSize);
+        }
+
+        fout->addU32(entries.size());
+        fout->addU32(offset);
+        fout->addU32(PACKAGE_SIGNATURE);
+        fout->flush();
+        fout->close();
+
+        g_logger.debug(stdext::format("Created package '%s' with %d files", packagePath, entries.size()));
+        return true;
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("Unable to create package '%s': %s", packageFile, e.what()));
+        return false;
+    }
+}
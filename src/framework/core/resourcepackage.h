@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef RESOURCEPACKAGE_H
+#define RESOURCEPACKAGE_H
+
+#include "declarations.h"
+
+/// Read only archive format for otpkg packages. The path index is loaded into a hash
+/// table when the package is mounted, so lookups never scan the archive. Entries are
+/// stored plain and read in place, or zlib compressed and inflated when opened.
+///
+/// Layout, all values little endian:
+///   u32 signature, u32 version, entry payloads,
+///   index: (u16 path length, path, u8 flags, u32 offset, u32 size, u32 raw size) per entry,
+///   footer: u32 entry count, u32 index offset, u32 signature
+class ResourcePackage
+{
+public:
+    /// Registers the archiver with physfs, otpkg files that are not in this format
+    /// are left to the other archivers (zip)
+    static bool registerArchiver();
+
+    /// Packs every file under directory into packageFile, compressing the entries
+    /// that get smaller
+    static bool create(const std::string& packageFile, const std::string& directory, bool compress);
+};
+
+#endif
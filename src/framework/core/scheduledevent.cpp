@@ -22,7 +22,7 @@
 
 #include "scheduledevent.h"
 
-ScheduledEvent::ScheduledEvent(const std::function<void()>& callback, int delay, int maxCycles) : Event(callback)
+ScheduledEvent::ScheduledEvent(EventCallback callback, int delay, int maxCycles) : Event(std::move(callback))
 {
     m_ticks = g_clock.millis() + delay;
     m_delay = delay;
@@ -44,6 +44,15 @@ void ScheduledEvent::execute()
     m_cyclesExecuted++;
 }
 
+void ScheduledEvent::cancel()
+{
+    Event::cancel();
+
+    // the wheel may hold the last reference, nothing can be touched after this
+    if(m_wheel)
+        m_wheel->remove(this);
+}
+
 bool ScheduledEvent::nextCycle()
 {
     if(m_callback && !m_canceled && (m_maxCycles == 0 || m_cyclesExecuted < m_maxCycles)) {
@@ -25,13 +25,15 @@
 
 #include "event.h"
 #include "clock.h"
+#include "timingwheel.h"
 
  // @bindclass
 class ScheduledEvent : public Event
 {
 public:
-    ScheduledEvent(const std::function<void()>& callback, int delay, int maxCycles);
+    ScheduledEvent(EventCallback callback, int delay, int maxCycles);
     void execute() override;
+    void cancel() override;
     bool nextCycle();
 
     int ticks() { return m_ticks; }
@@ -40,18 +42,19 @@ public:
     int cyclesExecuted() { return m_cyclesExecuted; }
     int maxCycles() { return m_maxCycles; }
 
-    struct Compare {
-        bool operator() (const ScheduledEventPtr& a, const ScheduledEventPtr& b) const
-        {
-            return b->ticks() < a->ticks();
-        }
-    };
-
 private:
     ticks_t m_ticks;
     int m_delay;
     int m_maxCycles;
     int m_cyclesExecuted;
+
+    // position in the dispatcher timing wheel, so a cancel can unlink it right away
+    TimingWheel* m_wheel{ nullptr };
+    ScheduledEventList* m_wheelList{ nullptr };
+    ScheduledEvent* m_wheelPrev{ nullptr };
+    ScheduledEvent* m_wheelNext{ nullptr };
+
+    friend class TimingWheel;
 };
 
 #endif
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "timingwheel.h"
+#include "scheduledevent.h"
+#include "clock.h"
+
+TimingWheel::~TimingWheel()
+{
+    clear();
+}
+
+void TimingWheel::insert(const ScheduledEventPtr& event)
+{
+    assert(!event->m_wheel);
+
+    // the wheel starts turning with the first event
+    if(m_currentTicks < 0)
+        m_currentTicks = g_clock.millis();
+
+    // the wheel keeps its own reference, released on removal or when the event expires
+    event->add_ref();
+    event->m_wheel = this;
+    place(event.get());
+    ++m_size;
+}
+
+void TimingWheel::remove(ScheduledEvent* event)
+{
+    if(event->m_wheel != this)
+        return;
+
+    unlink(event);
+    event->m_wheel = nullptr;
+    --m_size;
+    ++m_removedCount;
+    event->dec_ref();
+}
+
+void TimingWheel::clear()
+{
+    const auto cancelAll = [this](ScheduledEventList& list) {
+        while(list.head) {
+            ScheduledEvent* event = list.head;
+            unlink(event);
+            event->m_wheel = nullptr;
+            --m_size;
+
+            // adopts the wheel reference
+            ScheduledEventPtr(event, false)->cancel();
+        }
+    };
+
+    for(auto& level : m_slots) {
+        for(auto& list : level)
+            cancelAll(list);
+    }
+    cancelAll(m_expired);
+}
+
+ScheduledEventPtr TimingWheel::popExpired(ticks_t ticks)
+{
+    while(!m_expired.head) {
+        if(m_size == 0) {
+            // nothing to turn, skip straight to the present
+            m_currentTicks = std::max<ticks_t>(m_currentTicks, ticks + 1);
+            return nullptr;
+        }
+
+        if(m_currentTicks > ticks)
+            return nullptr;
+
+        const int index = m_currentTicks & SLOT_MASK;
+        if(index == 0) {
+            for(int level = 1; level < LEVEL_COUNT; ++level) {
+                const int slot = (m_currentTicks >> (SLOT_BITS * level)) & SLOT_MASK;
+                cascade(level, slot);
+                if(slot != 0)
+                    break;
+            }
+        }
+
+        // the whole slot moves to the expired list at once, events inserted while
+        // it's being consumed may land in the same slot of the next turn
+        ScheduledEventList& list = m_slots[0][index];
+        for(ScheduledEvent* event = list.head; event; event = event->m_wheelNext)
+            event->m_wheelList = &m_expired;
+        m_expired = list;
+        list = ScheduledEventList();
+
+        ++m_currentTicks;
+    }
+
+    ScheduledEvent* event = m_expired.head;
+    unlink(event);
+    event->m_wheel = nullptr;
+    --m_size;
+
+    // adopts the wheel reference
+    return ScheduledEventPtr(event, false);
+}
+
+void TimingWheel::place(ScheduledEvent* event)
+{
+    const ticks_t maxDelta = (static_cast<ticks_t>(1) << (SLOT_BITS * LEVEL_COUNT)) - 1;
+    const ticks_t expiration = std::max<ticks_t>(event->ticks(), m_currentTicks);
+
+    // events beyond the wheel range wait in the last level and are placed again when cascaded
+    const ticks_t delta = std::min<ticks_t>(expiration - m_currentTicks, maxDelta);
+    const ticks_t placement = m_currentTicks + delta;
+
+    int level = 0;
+    while(level < LEVEL_COUNT - 1 && delta >> (SLOT_BITS * (level + 1)))
+        ++level;
+
+    link(event, m_slots[level][(placement >> (SLOT_BITS * level)) & SLOT_MASK]);
+}
+
+void TimingWheel::cascade(int level, int slot)
+{
+    ScheduledEventList list = m_slots[level][slot];
+    m_slots[level][slot] = ScheduledEventList();
+
+    ScheduledEvent* event = list.head;
+    while(event) {
+        ScheduledEvent* next = event->m_wheelNext;
+        event->m_wheelPrev = event->m_wheelNext = nullptr;
+        place(event);
+        event = next;
+    }
+}
+
+void TimingWheel::link(ScheduledEvent* event, ScheduledEventList& list)
+{
+    event->m_wheelList = &list;
+    event->m_wheelPrev = list.tail;
+    event->m_wheelNext = nullptr;
+    if(list.tail)
+        list.tail->m_wheelNext = event;
+    else
+        list.head = event;
+    list.tail = event;
+}
+
+void TimingWheel::unlink(ScheduledEvent* event)
+{
+    ScheduledEventList& list = *event->m_wheelList;
+    if(event->m_wheelPrev)
+        event->m_wheelPrev->m_wheelNext = event->m_wheelNext;
+    else
+        list.head = event->m_wheelNext;
+    if(event->m_wheelNext)
+        event->m_wheelNext->m_wheelPrev = event->m_wheelPrev;
+    else
+        list.tail = event->m_wheelPrev;
+
+    event->m_wheelList = nullptr;
+    event->m_wheelPrev = event->m_wheelNext = nullptr;
+}
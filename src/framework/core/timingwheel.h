@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include "declarations.h"
+
+// intrusive list of the events sharing a wheel slot, in insertion order
+struct ScheduledEventList {
+    ScheduledEvent* head{ nullptr };
+    ScheduledEvent* tail{ nullptr };
+};
+
+// hierarchical timing wheel with millisecond resolution, four levels of 256 slots
+// cover about 49 days. inserting and removing an event is O(1), events further away
+// than the first level are cascaded down as the wheel turns
+class TimingWheel
+{
+public:
+    enum {
+        SLOT_BITS = 8,
+        SLOT_COUNT = 1 << SLOT_BITS,
+        SLOT_MASK = SLOT_COUNT - 1,
+        LEVEL_COUNT = 4
+    };
+
+    ~TimingWheel();
+
+    void insert(const ScheduledEventPtr& event);
+    void remove(ScheduledEvent* event);
+    void clear();
+
+    // returns the next event due at or before ticks, or nullptr when there is none
+    ScheduledEventPtr popExpired(ticks_t ticks);
+
+    size_t size() { return m_size; }
+    uint64 getRemovedCount() { return m_removedCount; }
+
+private:
+    void place(ScheduledEvent* event);
+    void cascade(int level, int slot);
+
+    void link(ScheduledEvent* event, ScheduledEventList& list);
+    void unlink(ScheduledEvent* event);
+
+    std::array<std::array<ScheduledEventList, SLOT_COUNT>, LEVEL_COUNT> m_slots;
+    ScheduledEventList m_expired;
+    ticks_t m_currentTicks{ -1 };
+    size_t m_size{ 0 };
+    uint64 m_removedCount{ 0 };
+};
+
+#endif
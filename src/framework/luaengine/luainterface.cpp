@@ -22,7 +22,9 @@
 
 #include "luainterface.h"
 #include "luaobject.h"
+#include "luaprofiler.h"
 
+#include <framework/core/profiler.h>
 #include <framework/core/resourcemanager.h>
 #if __has_include("luajit/lua.hpp")
 #include <luajit/lua.hpp>
@@ -32,11 +34,24 @@
 
 LuaInterface g_lua;
 
+namespace
+{
+    constexpr uint32 BYTECODE_SIGNATURE = 0x434C544F; // "OTLC"
+    constexpr uint32 BYTECODE_VERSION = 1;
+
+    int writeBytecode(lua_State*, const void* data, size_t size, void* userData)
+    {
+        static_cast<std::string*>(userData)->append(static_cast<const char*>(data), size);
+        return 0;
+    }
+}
+
 LuaInterface::LuaInterface()
 {
     L = nullptr;
     m_cppCallbackDepth = 0;
     m_weakTableRef = 0;
+    m_objectsTableRef = 0;
     m_totalObjRefs = 0;
     m_totalFuncRefs = 0;
 }
@@ -72,6 +87,8 @@ void LuaInterface::init()
 
 void LuaInterface::terminate()
 {
+    g_luaProfiler.terminate();
+
     // close lua state, it will release all objects
     closeLuaState();
     assert(m_totalFuncRefs == 0);
@@ -122,6 +139,28 @@ void LuaInterface::registerClass(const std::string & className, const std::strin
     pushValue(klass_fieldmethods);
     setField("fieldmethods", klass_mt);
 
+    const int classId = m_classes.size();
+    const auto baseIt = m_classIds.find(baseClass);
+    m_classes.push_back({ baseIt != m_classIds.end() && className != "LuaObject" ? baseIt->second : -1, -1, -1, {} });
+    m_classIds[className] = classId;
+    const LuaCppFunction classNewIndexEvent = [classId](LuaInterface* lua) { return luaClassNewIndexEvent(lua, classId); };
+
+    // creates the class methods and fieldmethods metatables, they watch new methods
+    // and getters so objects can tell when a cached field lookup is shadowed
+    newTable();
+    pushCppFunction(classNewIndexEvent);
+    setField("__newindex");
+    pushValue();
+    setMetatable(klass);
+    const int klass_methods_mt = getTop();
+
+    newTable();
+    pushCppFunction(classNewIndexEvent);
+    setField("__newindex");
+    pushValue();
+    setMetatable(klass_fieldmethods);
+    const int klass_fieldmethods_mt = getTop();
+
     // redirect methods and fieldmethods to the base class ones
     if(!className.empty() && className != "LuaObject") {
         // the following code is what create classes hierarchy for lua, by reproducing:
@@ -129,24 +168,21 @@ void LuaInterface::registerClass(const std::string & className, const std::strin
         // DerivedClass_fieldmethods = { __index = BaseClass_methods }
 
         // redirect the class methods to the base methods
-        pushValue(klass);
-        newTable();
         getGlobal(baseClass);
-        setField("__index");
-        setMetatable();
-        pop();
+        setField("__index", klass_methods_mt);
 
         // redirect the class fieldmethods to the base fieldmethods
-        pushValue(klass_fieldmethods);
-        newTable();
         getGlobal(baseClass + "_fieldmethods");
-        setField("__index");
-        setMetatable();
-        pop();
+        setField("__index", klass_fieldmethods_mt);
     }
 
-    // pops klass, klass_mt, klass_fieldmethods
-    pop(3);
+    pushValue(klass);
+    m_classes[classId].methodsRef = ref();
+    pushValue(klass_fieldmethods);
+    m_classes[classId].fieldMethodsRef = ref();
+
+    // pops klass, klass_mt, klass_fieldmethods and their metatables
+    pop(5);
 }
 
 void LuaInterface::registerClassStaticFunction(const std::string & className,
@@ -192,6 +228,55 @@ void LuaInterface::registerGlobalFunction(const std::string & functionName, cons
     setGlobal(functionName);
 }
 
+int LuaInterface::internField(const std::string & name)
+{
+    const auto it = m_fieldIds.find(name);
+    if(it != m_fieldIds.end())
+        return it->second;
+
+    const int fieldId = m_fields.size();
+    m_fields.push_back({ name });
+    m_fieldIds.emplace(name, fieldId);
+    return fieldId;
+}
+
+int LuaInterface::getClassId(LuaObject* object)
+{
+    const auto& tinfo = typeid(*object);
+    const auto it = m_typeClassIds.find(&tinfo);
+    if(it != m_typeClassIds.end())
+        return it->second;
+
+    const auto classIt = m_classIds.find(object->getClassName());
+    const int classId = classIt != m_classIds.end() ? classIt->second : -1;
+    m_typeClassIds.emplace(&tinfo, classId);
+    return classId;
+}
+
+int LuaInterface::getClassFieldFlags(int classId, int fieldId)
+{
+    // each class only remembers its own entries, the bases are asked in turn
+    int flags = 0;
+    for(; classId != -1; classId = m_classes[classId].base) {
+        LuaClass& klass = m_classes[classId];
+        auto it = klass.fieldFlags.find(fieldId);
+        if(it == klass.fieldFlags.end()) {
+            const LuaField& field = m_fields[fieldId];
+            getRef(klass.methodsRef);
+            pushString(field.name);
+            rawGet(-2);
+            getRef(klass.fieldMethodsRef);
+            pushString("get_" + field.name);
+            rawGet(-2);
+            const int ownFlags = (isNil(-3) ? 0 : ClassMethodField) | (isNil() ? 0 : ClassGetterField);
+            pop(4);
+            it = klass.fieldFlags.emplace(fieldId, ownFlags).first;
+        }
+        flags |= it->second;
+    }
+    return flags;
+}
+
 int LuaInterface::luaObjectGetEvent(LuaInterface * lua)
 {
     // stack: obj, key
@@ -296,6 +381,28 @@ int LuaInterface::luaObjectCollectEvent(LuaInterface * lua)
     return 0;
 }
 
+int LuaInterface::luaClassNewIndexEvent(LuaInterface * lua, int classId)
+{
+    // stack: class, key, value
+    lua->pushValue(-2);
+    const std::string key = lua->isString() ? lua->toString() : std::string();
+    lua->pop();
+    lua->rawSet(-3);
+    lua->pop();
+
+    // forget what this class knew about the field, getters are stored as get_<field>
+    auto& fieldFlags = lua->m_classes[classId].fieldFlags;
+    auto it = lua->m_fieldIds.find(key);
+    if(it != lua->m_fieldIds.end())
+        fieldFlags.erase(it->second);
+    if(stdext::starts_with(key, "get_")) {
+        it = lua->m_fieldIds.find(key.substr(4));
+        if(it != lua->m_fieldIds.end())
+            fieldFlags.erase(it->second);
+    }
+    return 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 bool LuaInterface::safeRunScript(const std::string & fileName)
@@ -332,7 +439,43 @@ void LuaInterface::loadScript(const std::string & fileName)
 
     const std::string buffer = g_resources.readFileContents(filePath);
     const std::string source = "@" + filePath;
+    if(m_bytecodeCacheEnabled && loadCachedBuffer(filePath, buffer, source))
+        return;
+
     loadBuffer(buffer, source);
+    if(m_bytecodeCacheEnabled)
+        saveCachedBuffer(filePath, buffer);
+}
+
+std::string LuaInterface::getBytecodeCacheFile(const std::string& filePath)
+{
+    return "/cache/lua" + filePath + "c";
+}
+
+bool LuaInterface::loadCachedBuffer(const std::string& filePath, const std::string& buffer, const std::string& source)
+{
+    std::string data;
+    if(!g_resources.readCacheFile(getBytecodeCacheFile(filePath), BYTECODE_SIGNATURE, BYTECODE_VERSION, filePath, buffer, data) || data.empty())
+        return false;
+
+    // a chunk dumped by another lua build fails here, the source is compiled again instead
+    if(luaL_loadbuffer(L, data.data(), data.size(), source.c_str()) != 0) {
+        pop();
+        return false;
+    }
+    return true;
+}
+
+void LuaInterface::saveCachedBuffer(const std::string& filePath, const std::string& buffer)
+{
+    if(g_resources.getWriteDir().empty())
+        return;
+
+    std::string data;
+    if(lua_dump(L, &writeBytecode, &data) != 0)
+        return;
+
+    g_resources.writeCacheFile(getBytecodeCacheFile(filePath), BYTECODE_SIGNATURE, BYTECODE_VERSION, filePath, buffer, data);
 }
 
 void LuaInterface::loadFunction(const std::string & buffer, const std::string & source)
@@ -432,6 +575,7 @@ std::string LuaInterface::getCurrentSourcePath(int level)
 
 int LuaInterface::safeCall(int numArgs, int numRets)
 {
+    PROFILE_SCOPE("lua call");
     assert(hasIndex(-numArgs - 1));
 
     // saves the current stack size for calculating the number of results later
@@ -631,11 +775,28 @@ int LuaInterface::luaCppFunctionCallback(lua_State*)
 
     int numRets = 0;
 
+    // keeps the callback depth and the profiler right when the bound function throws
+    struct CallScope
+    {
+        CallScope() : profiling(g_luaProfiler.isEnabled()),
+            profileStart(profiling ? stdext::micros() : 0),
+            profileAccounted(profiling ? g_luaProfiler.getAccountedTime() : 0) { g_lua.m_cppCallbackDepth++; }
+        ~CallScope()
+        {
+            g_lua.m_cppCallbackDepth--;
+            if(profiling && g_luaProfiler.isEnabled())
+                g_luaProfiler.endCppCall(profileStart, profileAccounted);
+        }
+
+        const bool profiling;
+        const ticks_t profileStart;
+        const ticks_t profileAccounted;
+    };
+
     // do the call
     try {
-        g_lua.m_cppCallbackDepth++;
+        CallScope scope;
         numRets = (*(funcPtr->get()))(&g_lua);
-        g_lua.m_cppCallbackDepth--;
         assert(numRets == g_lua.stackSize());
     } catch(stdext::exception& e) {
         // cleanup stack
@@ -671,6 +832,9 @@ void LuaInterface::createLuaState()
     // load lua standard libraries
     luaL_openlibs(L);
 
+    lua_gc(L, LUA_GCSETPAUSE, m_gcPause);
+    lua_gc(L, LUA_GCSETSTEPMUL, m_gcStepMultiplier);
+
     // creates weak table
     newTable();
     newTable();
@@ -679,6 +843,14 @@ void LuaInterface::createLuaState()
     setMetatable();
     m_weakTableRef = ref();
 
+    // creates the weak table caching the userdata of each object pushed to lua
+    newTable();
+    newTable();
+    pushString("v");
+    setField("__mode");
+    setMetatable();
+    m_objectsTableRef = ref();
+
     // installs script loader
     getGlobal("package");
     getField("loaders");
@@ -706,6 +878,10 @@ void LuaInterface::closeLuaState()
         lua_close(L);
         L = nullptr;
     }
+
+    m_classes.clear();
+    m_classIds.clear();
+    m_typeClassIds.clear();
 }
 
 void LuaInterface::collectGarbage()
@@ -722,6 +898,66 @@ void LuaInterface::collectGarbage()
 
         collecting = false;
     }
+
+    // a full collection restarts the automatic collector
+    if(m_gcCycleRunning || m_gcThreshold > 0) {
+        m_gcCycleRunning = false;
+        m_gcThreshold = getMemoryUsage() * (m_gcPause / 100.0);
+        lua_gc(L, LUA_GCSTOP, 0);
+    }
+}
+
+void LuaInterface::stepGarbageCollector(ticks_t maxMicros)
+{
+    m_gcLastStepTime = 0;
+
+    // like the automatic collector, waits the memory to grow by the pause
+    // percentage over the memory left by the last cycle before starting another
+    if(!m_gcCycleRunning) {
+        if(getMemoryUsage() < m_gcThreshold) {
+            lua_gc(L, LUA_GCSTOP, 0);
+            return;
+        }
+        m_gcCycleRunning = true;
+    }
+
+    PROFILE_SCOPE("lua gc");
+    const ticks_t startTime = stdext::micros();
+    const ticks_t maxTime = std::min<ticks_t>(maxMicros, m_gcMaxStepTime);
+    do {
+        if(lua_gc(L, LUA_GCSTEP, 0)) {
+            // cycle finished
+            m_gcCycleRunning = false;
+            m_gcThreshold = getMemoryUsage() * (m_gcPause / 100.0);
+            break;
+        }
+    } while(stdext::micros() - startTime < maxTime);
+
+    // each step rearms the automatic collector, keep it stopped until the next frame,
+    // unless the steps are falling behind the allocations, then lua paces itself
+    if(!m_gcCycleRunning || getMemoryUsage() < 2 * std::max<int>(m_gcThreshold, 1024))
+        lua_gc(L, LUA_GCSTOP, 0);
+
+    m_gcLastStepTime = stdext::micros() - startTime;
+}
+
+void LuaInterface::setGarbageCollectorPause(int pause)
+{
+    m_gcPause = std::max<int>(pause, 100);
+    if(L)
+        lua_gc(L, LUA_GCSETPAUSE, m_gcPause);
+}
+
+void LuaInterface::setGarbageCollectorStepMultiplier(int stepMultiplier)
+{
+    m_gcStepMultiplier = std::max<int>(stepMultiplier, 100);
+    if(L)
+        lua_gc(L, LUA_GCSETSTEPMUL, m_gcStepMultiplier);
+}
+
+int LuaInterface::getMemoryUsage()
+{
+    return lua_gc(L, LUA_GCCOUNT, 0);
 }
 
 void LuaInterface::loadBuffer(const std::string & buffer, const std::string & source)
@@ -1106,6 +1342,20 @@ void LuaInterface::pushThread()
 
 void LuaInterface::pushObject(const LuaObjectPtr & obj)
 {
+    // reuses the userdata of this object while lua still references it,
+    // the weak table drops it once it gets collected
+    getRef(m_objectsTableRef);
+    pushLightUserdata(obj.get());
+    rawGet(-2);
+    if(isUserdata()) {
+        const auto objPtr = static_cast<LuaObjectPtr*>(toUserdata());
+        if(objPtr && *objPtr == obj) {
+            remove(-2); // removes the objects table
+            return;
+        }
+    }
+    pop(); // pops the stale value
+
     // fills a new userdata with a new LuaObjectPtr pointer
     new(newUserdata(sizeof(LuaObjectPtr))) LuaObjectPtr(obj);
     m_totalObjRefs++;
@@ -1114,6 +1364,12 @@ void LuaInterface::pushObject(const LuaObjectPtr & obj)
     if(isNil())
         g_logger.fatal(stdext::format("metatable for class '%s' not found, did you bind the C++ class?", obj->getClassName()));
     setMetatable();
+
+    // objects_table[obj] = userdata
+    pushLightUserdata(obj.get());
+    pushValue(-2);
+    rawSet(-4);
+    remove(-2); // removes the objects table
 }
 
 void LuaInterface::pushCFunction(LuaCFunction func, int n)
@@ -122,6 +122,21 @@ public:
     template<typename F>
     void bindGlobalFunction(const std::string& functionName, const F& function);
 
+    /// Interns a field name, the returned id is used by LuaObject to cache its field lookups
+    int internField(const std::string& name);
+    const std::string& getFieldName(int fieldId) { return m_fields[fieldId].name; }
+
+    enum ClassFieldFlags {
+        ClassMethodField = 1,
+        ClassGetterField = 2
+    };
+
+    /// Returns the id of the class registered for the object type, -1 if there is none
+    int getClassId(LuaObject* object);
+    /// Tells whether the class or one of its bases has a method or a getter
+    /// for the field, as a combination of ClassFieldFlags
+    int getClassFieldFlags(int classId, int fieldId);
+
 private:
     /// Metamethod that will retrieve fields values (that include functions) from the object when using '.' or ':'
     static int luaObjectGetEvent(LuaInterface* lua);
@@ -134,6 +149,9 @@ private:
     /// anymore, thus this creates the possibility of holding an object
     /// existence by lua until it got no references left
     static int luaObjectCollectEvent(LuaInterface* lua);
+    /// Metamethod called when a new field is assigned to a class methods or fieldmethods table,
+    /// drops what that class cached about the field
+    static int luaClassNewIndexEvent(LuaInterface* lua, int classId);
 
 public:
     /// Loads and runs a script, any errors are printed to stdout and returns false
@@ -151,6 +169,13 @@ public:
     /// @exception LuaException is thrown on any lua error
     void loadScript(const std::string& fileName);
 
+    /// Compiled chunks of loaded scripts are kept under /cache/lua in the write dir and
+    /// reused while the script modification time, size and checksum are unchanged.
+    /// Disabled by default: luajit does not verify bytecode and the checksum is no secret,
+    /// so only enable it when nobody else can write into the write dir
+    void setBytecodeCacheEnabled(bool enable) { m_bytecodeCacheEnabled = enable; }
+    bool isBytecodeCacheEnabled() { return m_bytecodeCacheEnabled; }
+
     /// Loads a function from buffer and pushes it onto stack,
     /// @exception LuaException is thrown on any lua error
     void loadFunction(const std::string& buffer, const std::string& source = "lua function buffer");
@@ -225,6 +250,20 @@ public:
 
     void collectGarbage();
 
+    /// Runs incremental collection steps for up to maxMicros (at least one step), the automatic
+    /// collector is kept stopped between calls so it does not kick in the middle of a frame
+    void stepGarbageCollector(ticks_t maxMicros);
+    void setGarbageCollectorPause(int pause);
+    void setGarbageCollectorStepMultiplier(int stepMultiplier);
+    void setGarbageCollectorMaxStepTime(ticks_t micros) { m_gcMaxStepTime = std::max<ticks_t>(micros, 0); }
+    int getGarbageCollectorPause() { return m_gcPause; }
+    int getGarbageCollectorStepMultiplier() { return m_gcStepMultiplier; }
+    ticks_t getGarbageCollectorMaxStepTime() { return m_gcMaxStepTime; }
+    /// Time spent by the last stepGarbageCollector call, in microseconds
+    ticks_t getLastGarbageCollectorTime() { return m_gcLastStepTime; }
+    /// Memory in use by lua, in kilobytes
+    int getMemoryUsage();
+
     void loadBuffer(const std::string& buffer, const std::string& source);
 
     int pcall(int numArgs = 0, int numRets = 0, int errorFuncIndex = 0);
@@ -343,12 +382,50 @@ public:
     T polymorphicPop() { T v = castValue<T>(); pop(1); return v; }
 
 private:
+    static std::string getBytecodeCacheFile(const std::string& filePath);
+    /// Pushes the cached chunk of filePath, returns false when there is no valid cache for buffer
+    bool loadCachedBuffer(const std::string& filePath, const std::string& buffer, const std::string& source);
+    /// Dumps the chunk on the top of the stack into the cache of filePath
+    void saveCachedBuffer(const std::string& filePath, const std::string& buffer);
+
     lua_State* L;
     int m_weakTableRef;
+    int m_objectsTableRef;
     int m_cppCallbackDepth;
     int m_totalObjRefs;
     int m_totalFuncRefs;
     int m_globalEnv;
+
+    int m_gcPause{ 200 };
+    int m_gcStepMultiplier{ 200 };
+    int m_gcThreshold{ 0 };
+    bool m_gcCycleRunning{ false };
+    ticks_t m_gcMaxStepTime{ 2000 };
+    ticks_t m_gcLastStepTime{ 0 };
+
+    bool m_bytecodeCacheEnabled{ false };
+
+    struct LuaField
+    {
+        std::string name;
+    };
+
+    struct LuaClass
+    {
+        int base;
+        int methodsRef;
+        int fieldMethodsRef;
+        // flags of the class own methods and getters, filled on demand
+        std::unordered_map<int, int> fieldFlags;
+    };
+
+    std::vector<LuaField> m_fields;
+    std::unordered_map<std::string, int> m_fieldIds;
+    std::vector<LuaClass> m_classes;
+    std::unordered_map<std::string, int> m_classIds;
+    std::unordered_map<const std::type_info*, int> m_typeClassIds;
+
+    friend class LuaProfiler;
 };
 
 extern LuaInterface g_lua;
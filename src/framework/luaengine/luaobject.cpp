@@ -26,6 +26,8 @@
 #include <typeinfo>
 #include <framework/core/application.h>
 
+LuaFieldKey::LuaFieldKey(const std::string& name) : id(g_lua.internField(name)) {}
+
 LuaObject::~LuaObject()
 {
 #ifndef NDEBUG
@@ -52,6 +54,55 @@ void LuaObject::releaseLuaFieldsTable()
         g_lua.unref(m_fieldsTableRef);
         m_fieldsTableRef = -1;
     }
+
+    if(m_fieldRefs) {
+        for(const auto& fieldRef : *m_fieldRefs)
+            g_lua.unref(fieldRef.second);
+        m_fieldRefs.reset();
+    }
+    m_fieldsMask = 0;
+}
+
+LuaObject::LuaListener LuaObject::luaPushListener(const LuaFieldKey& field)
+{
+    // the fields table may be changed behind our back once lua got it
+    if(m_fieldsExposed)
+        return LookupLuaListener;
+
+    if(m_luaClassId == -2)
+        m_luaClassId = g_lua.getClassId(this);
+    if(m_luaClassId == -1)
+        return LookupLuaListener;
+
+    // a getter takes precedence over the object own fields, a method is only used when the object has none
+    const int classFlags = g_lua.getClassFieldFlags(m_luaClassId, field.id);
+    if(classFlags & LuaInterface::ClassGetterField)
+        return LookupLuaListener;
+    const LuaListener noFieldListener = (classFlags & LuaInterface::ClassMethodField) ? LookupLuaListener : NoLuaListener;
+
+    // the field was never set in this object
+    if(!(m_fieldsMask & (1ULL << (field.id % 64))))
+        return noFieldListener;
+
+    if(!m_fieldRefs)
+        m_fieldRefs = std::make_unique<std::vector<std::pair<int, int>>>();
+
+    auto it = std::find_if(m_fieldRefs->begin(), m_fieldRefs->end(), [&](const std::pair<int, int>& fieldRef) { return fieldRef.first == field.id; });
+    if(it == m_fieldRefs->end()) {
+        int ref = -1;
+        luaGetField(g_lua.getFieldName(field.id));
+        if(g_lua.isNil())
+            g_lua.pop();
+        else
+            ref = g_lua.ref();
+        it = m_fieldRefs->emplace(m_fieldRefs->end(), field.id, ref);
+    }
+
+    if(it->second == -1)
+        return noFieldListener;
+
+    g_lua.getRef(it->second);
+    return CachedLuaListener;
 }
 
 void LuaObject::luaSetField(const std::string& key)
@@ -66,6 +117,17 @@ void LuaObject::luaSetField(const std::string& key)
     g_lua.insert(-2); // move the value to the top
     g_lua.setField(key); // set the field
     g_lua.pop(); // pop the fields table
+
+    // drop the cached listener of this field
+    const int fieldId = g_lua.internField(key);
+    m_fieldsMask |= 1ULL << (fieldId % 64);
+    if(m_fieldRefs) {
+        const auto it = std::find_if(m_fieldRefs->begin(), m_fieldRefs->end(), [&](const std::pair<int, int>& fieldRef) { return fieldRef.first == fieldId; });
+        if(it != m_fieldRefs->end()) {
+            g_lua.unref(it->second);
+            m_fieldRefs->erase(it);
+        }
+    }
 }
 
 void LuaObject::luaGetField(const std::string& key)
@@ -98,6 +160,7 @@ void LuaObject::luaGetMetatable()
 
 void LuaObject::luaGetFieldsTable()
 {
+    m_fieldsExposed = true;
     if(m_fieldsTableRef != -1)
         g_lua.getRef(m_fieldsTableRef);
     else
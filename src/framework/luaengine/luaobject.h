@@ -25,6 +25,14 @@
 
 #include "declarations.h"
 
+/// Interned name of a lua field, hot callers keep it in a static to skip
+/// the name lookup and to reuse the object cached field references
+struct LuaFieldKey
+{
+    explicit LuaFieldKey(const std::string& name);
+    int id;
+};
+
  /// LuaObject, all script-able classes have it as base
  // @bindclass
 class LuaObject : public stdext::shared_object
@@ -41,11 +49,17 @@ public:
     /// @return the number of results
     template<typename... T>
     int luaCallLuaField(const std::string& field, const T&... args);
+    template<typename... T>
+    int luaCallLuaField(const LuaFieldKey& field, const T&... args);
 
     template<typename R, typename... T>
     R callLuaField(const std::string& field, const T&... args);
+    template<typename R, typename... T>
+    R callLuaField(const LuaFieldKey& field, const T&... args);
     template<typename... T>
     void callLuaField(const std::string& field, const T&... args);
+    template<typename... T>
+    void callLuaField(const LuaFieldKey& field, const T&... args);
 
     /// Returns true if the lua field exists
     bool hasLuaField(const std::string& field);
@@ -85,7 +99,21 @@ public:
     void operator=(const LuaObject&) {}
 
 private:
+    enum LuaListener {
+        NoLuaListener,
+        CachedLuaListener,
+        LookupLuaListener
+    };
+
+    /// Pushes the cached listener of a field when it can be used,
+    /// otherwise tells if the field is surely nil or must be looked up
+    LuaListener luaPushListener(const LuaFieldKey& field);
+
     int m_fieldsTableRef{ -1 };
+    uint64 m_fieldsMask{ 0 };
+    bool m_fieldsExposed{ false };
+    int m_luaClassId{ -2 };
+    std::unique_ptr<std::vector<std::pair<int, int>>> m_fieldRefs;
 };
 
 template<typename F>
@@ -151,6 +179,23 @@ connect(const LuaObjectPtr& obj, const std::string& field, const Lambda& f, bool
     luabinder::connect_lambda<F>::call(obj, field, f, pushFront);
 }
 
+template<typename... T>
+int LuaObject::luaCallLuaField(const LuaFieldKey& field, const T&... args)
+{
+    switch(luaPushListener(field)) {
+        case NoLuaListener:
+            return 0;
+        case CachedLuaListener: {
+            // the first argument is always this object (self)
+            g_lua.pushObject(asLuaObject());
+            const int numArgs = g_lua.polymorphicPush(args...);
+            return g_lua.signalCall(1 + numArgs);
+        }
+        default:
+            return luaCallLuaField(g_lua.getFieldName(field.id), args...);
+    }
+}
+
 template<typename... T>
 int LuaObject::luaCallLuaField(const std::string& field, const T&... args)
 {
@@ -184,6 +229,19 @@ R LuaObject::callLuaField(const std::string& field, const T&... args)
     return result;
 }
 
+template<typename R, typename... T>
+R LuaObject::callLuaField(const LuaFieldKey& field, const T&... args)
+{
+    R result;
+    const int rets = luaCallLuaField(field, args...);
+    if(rets > 0) {
+        assert(rets == 1);
+        result = g_lua.polymorphicPop<R>();
+    } else
+        result = R();
+    return result;
+}
+
 template<typename... T>
 void LuaObject::callLuaField(const std::string& field, const T&... args)
 {
@@ -192,6 +250,14 @@ void LuaObject::callLuaField(const std::string& field, const T&... args)
         g_lua.pop(rets);
 }
 
+template<typename... T>
+void LuaObject::callLuaField(const LuaFieldKey& field, const T&... args)
+{
+    const int rets = luaCallLuaField(field, args...);
+    if(rets > 0)
+        g_lua.pop(rets);
+}
+
 template<typename T>
 void LuaObject::setLuaField(const std::string& key, const T& value)
 {
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "luaprofiler.h"
+#include "luainterface.h"
+
+#include <framework/core/modulemanager.h>
+#include <framework/core/resourcemanager.h>
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <sstream>
+
+#if __has_include("luajit/lua.hpp")
+#include <luajit/lua.hpp>
+#else
+#include <lua.hpp>
+#endif
+
+LuaProfiler g_luaProfiler;
+
+void LuaProfiler::terminate()
+{
+    setEnabled(false);
+    reset();
+}
+
+void LuaProfiler::setEnabled(bool enabled)
+{
+    if(m_enabled == enabled || !g_lua.L)
+        return;
+
+    m_enabled = enabled;
+    if(enabled) {
+        m_lastSampleTime = stdext::micros();
+        m_excludedTime = 0;
+        lua_sethook(g_lua.L, &LuaProfiler::hook, LUA_MASKCOUNT, HOOK_INSTRUCTIONS);
+    } else
+        lua_sethook(g_lua.L, nullptr, 0, 0);
+}
+
+void LuaProfiler::reset()
+{
+    m_stacks.clear();
+    m_sourceModules.clear();
+    m_pendingCppTime = 0;
+    m_totalWeight = 0;
+    m_sampleCount = 0;
+}
+
+std::string LuaProfiler::getReport(int limit)
+{
+    std::unordered_map<std::string, ticks_t> selfTimes;
+    std::unordered_map<std::string, ticks_t> totalTimes;
+    std::unordered_map<std::string, ticks_t> moduleTimes;
+
+    for(const auto& it : m_stacks) {
+        const std::vector<std::string> frames = stdext::split(it.first, ";");
+        if(frames.empty())
+            continue;
+
+        // recursive functions are counted once in the inclusive time
+        std::set<std::string> seen;
+        for(const std::string& frame : frames) {
+            if(seen.insert(frame).second)
+                totalTimes[frame] += it.second;
+        }
+
+        // the module is the one owning the innermost lua function
+        selfTimes[frames.back()] += it.second;
+        for(auto frame = frames.rbegin(); frame != frames.rend(); ++frame) {
+            const std::size_t pos = frame->find(" @");
+            if(pos != std::string::npos) {
+                moduleTimes[getModuleName(frame->substr(pos + 2))] += it.second;
+                break;
+            }
+        }
+    }
+
+    const auto sorted = [limit](const std::unordered_map<std::string, ticks_t>& times) {
+        std::vector<std::pair<std::string, ticks_t>> entries(times.begin(), times.end());
+        std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+        if(limit > 0 && entries.size() > static_cast<std::size_t>(limit))
+            entries.resize(limit);
+        return entries;
+    };
+
+    std::stringstream ss;
+    ss << stdext::format("%d samples, %.2f ms", m_sampleCount, m_totalWeight / 1000.0) << "\n";
+    ss << "modules (self ms):\n";
+    for(const auto& entry : sorted(moduleTimes))
+        ss << stdext::format("%10.2f  %s", entry.second / 1000.0, entry.first) << "\n";
+    ss << "functions (self ms, total ms):\n";
+    for(const auto& entry : sorted(selfTimes))
+        ss << stdext::format("%10.2f %10.2f  %s", entry.second / 1000.0, totalTimes[entry.first] / 1000.0, entry.first) << "\n";
+    return ss.str();
+}
+
+bool LuaProfiler::dumpCollapsedStacks(const std::string& fileName)
+{
+    std::stringstream ss;
+    for(const auto& it : m_stacks)
+        ss << it.first << " " << it.second << "\n";
+    return g_resources.writeFileContents(fileName, ss.str());
+}
+
+void LuaProfiler::endCppCall(ticks_t startTime, ticks_t startAccounted)
+{
+    // lua code and nested bindings called back from C++ were already accounted on their own
+    const ticks_t elapsed = stdext::micros() - startTime - (getAccountedTime() - startAccounted);
+    if(elapsed <= 0)
+        return;
+
+    // the lua stack of the caller is only walked once enough C++ time piled up
+    m_excludedTime += elapsed;
+    m_pendingCppTime += elapsed;
+    if(m_pendingCppTime < m_sampleInterval)
+        return;
+
+    lua_Debug ar;
+    std::string leaf = "[C++]";
+    if(lua_getstack(g_lua.L, 0, &ar) && lua_getinfo(g_lua.L, "n", &ar) && ar.name)
+        leaf = stdext::format("[C++] %s", ar.name);
+
+    const ticks_t weight = m_pendingCppTime;
+    m_pendingCppTime = 0;
+    sample(leaf.c_str(), weight);
+}
+
+void LuaProfiler::hook(lua_State*, lua_Debug*)
+{
+    LuaProfiler& profiler = g_luaProfiler;
+    const ticks_t now = stdext::micros();
+    const ticks_t elapsed = now - profiler.m_lastSampleTime;
+    if(elapsed < profiler.m_sampleInterval)
+        return;
+
+    const ticks_t weight = elapsed - std::min<ticks_t>(profiler.m_excludedTime, elapsed);
+    profiler.m_lastSampleTime = now;
+    profiler.m_excludedTime = 0;
+    if(weight > 0)
+        profiler.sample(nullptr, weight);
+}
+
+void LuaProfiler::sample(const char* leaf, ticks_t weight)
+{
+    std::vector<std::string> frames;
+    lua_Debug ar;
+    for(int level = 0; lua_getstack(g_lua.L, level, &ar); ++level) {
+        if(!lua_getinfo(g_lua.L, "Sn", &ar))
+            break;
+
+        const char* name = ar.name ? ar.name : "?";
+        if(ar.what && strcmp(ar.what, "C") == 0)
+            frames.push_back(stdext::format("[C] %s", name));
+        else if(ar.what && strcmp(ar.what, "main") == 0)
+            frames.push_back(stdext::format("main @%s", ar.short_src));
+        else
+            frames.push_back(stdext::format("%s @%s:%d", name, ar.short_src, ar.linedefined));
+    }
+
+    std::string stack;
+    for(auto frame = frames.rbegin(); frame != frames.rend(); ++frame) {
+        if(!stack.empty())
+            stack += ";";
+        stack += *frame;
+    }
+    if(leaf) {
+        if(!stack.empty())
+            stack += ";";
+        stack += leaf;
+    }
+    if(stack.empty())
+        return;
+
+    m_stacks[stack] += weight;
+    m_totalWeight += weight;
+    ++m_sampleCount;
+}
+
+std::string LuaProfiler::getModuleName(const std::string& frameSource)
+{
+    // strip the line number from the frame source
+    const std::string source = frameSource.substr(0, frameSource.rfind(':'));
+    const auto it = m_sourceModules.find(source);
+    if(it != m_sourceModules.end())
+        return it->second;
+
+    // long sources are cut by lua to "..." followed by the end of the path,
+    // then the module path may be cut as well and only its end can be matched
+    const bool truncated = stdext::starts_with(source, "...");
+    const std::string tail = truncated ? source.substr(3) : source;
+    const auto matchLength = [&](const std::string& prefix) -> std::size_t {
+        const std::size_t maxCut = truncated ? prefix.length() : 1;
+        for(std::size_t cut = 0; cut < maxCut; ++cut) {
+            if(stdext::starts_with(tail, prefix.substr(cut)))
+                return prefix.length() - cut;
+        }
+        return 0;
+    };
+
+    std::string moduleName = "?";
+    std::size_t bestLength = 0;
+    for(const ModulePtr& module : g_modules.getModules()) {
+        const std::size_t length = matchLength(module->getPath() + "/");
+        if(length > bestLength) {
+            moduleName = module->getName();
+            bestLength = length;
+        }
+    }
+
+    m_sourceModules[source] = moduleName;
+    return moduleName;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LUAPROFILER_H
+#define LUAPROFILER_H
+
+#include "declarations.h"
+
+struct lua_State;
+struct lua_Debug;
+
+// Statistical profiler for lua code, a count hook takes a stack sample whenever the sample interval
+// has elapsed and charges the elapsed time to it. Time spent inside C++ bindings is charged to a
+// [C++] frame on top of the calling lua stack.
+// @bindsingleton g_luaProfiler
+class LuaProfiler
+{
+public:
+    enum {
+        HOOK_INSTRUCTIONS = 1000
+    };
+
+    void terminate();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() { return m_enabled; }
+    void setSampleInterval(int micros) { m_sampleInterval = std::max<int>(micros, 1); }
+    int getSampleInterval() { return m_sampleInterval; }
+    void reset();
+
+    // text report of the most expensive functions and modules, as shown by the terminal
+    std::string getReport(int limit);
+    // one line per distinct stack, in the collapsed format of flamegraph.pl
+    bool dumpCollapsedStacks(const std::string& fileName);
+
+    uint64 getSampleCount() { return m_sampleCount; }
+
+    // @dontbind
+    void endCppCall(ticks_t startTime, ticks_t startAccounted);
+    // @dontbind
+    ticks_t getAccountedTime() { return m_totalWeight + m_pendingCppTime; }
+
+private:
+    static void hook(lua_State* L, lua_Debug* ar);
+    void sample(const char* leaf, ticks_t weight);
+    std::string getModuleName(const std::string& source);
+
+    bool m_enabled{ false };
+    int m_sampleInterval{ 1000 };
+    ticks_t m_lastSampleTime{ 0 };
+    ticks_t m_excludedTime{ 0 };
+    ticks_t m_pendingCppTime{ 0 };
+    ticks_t m_totalWeight{ 0 };
+    uint64 m_sampleCount{ 0 };
+
+    // stack frames from the outermost to the leaf, joined by ';'
+    std::unordered_map<std::string, ticks_t> m_stacks;
+    std::unordered_map<std::string, std::string> m_sourceModules;
+};
+
+extern LuaProfiler g_luaProfiler;
+
+#endif
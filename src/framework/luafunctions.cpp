@@ -22,7 +22,9 @@
 
 #include <framework/core/application.h>
 #include <framework/luaengine/luainterface.h>
+#include <framework/luaengine/luaprofiler.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/core/profiler.h>
 #include <framework/core/configmanager.h>
 #include <framework/core/config.h>
 #include <framework/otml/otml.h>
@@ -147,6 +149,8 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_logger", "fireOldMessages", &Logger::fireOldMessages, &g_logger);
     g_lua.bindSingletonFunction("g_logger", "setLogFile", &Logger::setLogFile, &g_logger);
     g_lua.bindSingletonFunction("g_logger", "setOnLog", &Logger::setOnLog, &g_logger);
+    g_lua.bindSingletonFunction("g_logger", "setLevel", &Logger::setLevel, &g_logger);
+    g_lua.bindSingletonFunction("g_logger", "getLevel", &Logger::getLevel, &g_logger);
     g_lua.bindSingletonFunction("g_logger", "debug", &Logger::debug, &g_logger);
     g_lua.bindSingletonFunction("g_logger", "info", &Logger::info, &g_logger);
     g_lua.bindSingletonFunction("g_logger", "warning", &Logger::warning, &g_logger);
@@ -164,11 +168,55 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_modules", "getModule", &ModuleManager::getModule, &g_modules);
     g_lua.bindSingletonFunction("g_modules", "getModules", &ModuleManager::getModules, &g_modules);
 
+    // Profiler
+    g_lua.registerSingletonClass("g_profiler");
+    g_lua.bindSingletonFunction("g_profiler", "setEnabled", &Profiler::setEnabled, &g_profiler);
+    g_lua.bindSingletonFunction("g_profiler", "isEnabled", &Profiler::isEnabled, &g_profiler);
+    g_lua.bindSingletonFunction("g_profiler", "dumpTrace", &Profiler::dumpTrace, &g_profiler);
+    g_lua.bindSingletonFunction("g_profiler", "getFrameCount", &Profiler::getFrameCount, &g_profiler);
+
+    // LuaProfiler
+    g_lua.registerSingletonClass("g_luaProfiler");
+    g_lua.bindSingletonFunction("g_luaProfiler", "setEnabled", &LuaProfiler::setEnabled, &g_luaProfiler);
+    g_lua.bindSingletonFunction("g_luaProfiler", "isEnabled", &LuaProfiler::isEnabled, &g_luaProfiler);
+    g_lua.bindSingletonFunction("g_luaProfiler", "setSampleInterval", &LuaProfiler::setSampleInterval, &g_luaProfiler);
+    g_lua.bindSingletonFunction("g_luaProfiler", "getSampleInterval", &LuaProfiler::getSampleInterval, &g_luaProfiler);
+    g_lua.bindSingletonFunction("g_luaProfiler", "reset", &LuaProfiler::reset, &g_luaProfiler);
+    g_lua.bindSingletonFunction("g_luaProfiler", "getReport", &LuaProfiler::getReport, &g_luaProfiler);
+    g_lua.bindSingletonFunction("g_luaProfiler", "dumpCollapsedStacks", &LuaProfiler::dumpCollapsedStacks, &g_luaProfiler);
+    g_lua.bindSingletonFunction("g_luaProfiler", "getSampleCount", &LuaProfiler::getSampleCount, &g_luaProfiler);
+
+    // LuaInterface
+    g_lua.registerSingletonClass("g_lua");
+    g_lua.bindSingletonFunction("g_lua", "collectGarbage", &LuaInterface::collectGarbage, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "setGarbageCollectorPause", &LuaInterface::setGarbageCollectorPause, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "setGarbageCollectorStepMultiplier", &LuaInterface::setGarbageCollectorStepMultiplier, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "setGarbageCollectorMaxStepTime", &LuaInterface::setGarbageCollectorMaxStepTime, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "getGarbageCollectorPause", &LuaInterface::getGarbageCollectorPause, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "getGarbageCollectorStepMultiplier", &LuaInterface::getGarbageCollectorStepMultiplier, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "getGarbageCollectorMaxStepTime", &LuaInterface::getGarbageCollectorMaxStepTime, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "getLastGarbageCollectorTime", &LuaInterface::getLastGarbageCollectorTime, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "getMemoryUsage", &LuaInterface::getMemoryUsage, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "setBytecodeCacheEnabled", &LuaInterface::setBytecodeCacheEnabled, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "isBytecodeCacheEnabled", &LuaInterface::isBytecodeCacheEnabled, &g_lua);
+
     // EventDispatcher
     g_lua.registerSingletonClass("g_dispatcher");
-    g_lua.bindSingletonFunction("g_dispatcher", "addEvent", &EventDispatcher::addEvent, &g_dispatcher);
-    g_lua.bindSingletonFunction("g_dispatcher", "scheduleEvent", &EventDispatcher::scheduleEvent, &g_dispatcher);
-    g_lua.bindSingletonFunction("g_dispatcher", "cycleEvent", &EventDispatcher::cycleEvent, &g_dispatcher);
+    g_lua.bindClassStaticFunction("g_dispatcher", "addEvent", [](const std::function<void()>& callback, bool pushFront) { return g_dispatcher.addEvent(callback, pushFront); });
+    g_lua.bindClassStaticFunction("g_dispatcher", "addPriorityEvent", [](const std::function<void()>& callback, int priority) { return g_dispatcher.addPriorityEvent(callback, static_cast<Fw::EventPriority>(std::clamp<int>(priority, 0, Fw::LastEventPriority - 1))); });
+    g_lua.bindClassStaticFunction("g_dispatcher", "scheduleEvent", [](const std::function<void()>& callback, int delay) { return g_dispatcher.scheduleEvent(callback, delay); });
+    g_lua.bindClassStaticFunction("g_dispatcher", "cycleEvent", [](const std::function<void()>& callback, int delay) { return g_dispatcher.cycleEvent(callback, delay); });
+    g_lua.bindSingletonFunction("g_dispatcher", "getLiveEventCount", &EventDispatcher::getLiveEventCount, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "getCancelledEventCount", &EventDispatcher::getCancelledEventCount, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "getFiredEventCount", &EventDispatcher::getFiredEventCount, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "getCreatedEventCount", &EventDispatcher::getCreatedEventCount, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "getEventHeapAllocationCount", &EventDispatcher::getEventHeapAllocationCount, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "getCallbackHeapAllocationCount", &EventDispatcher::getCallbackHeapAllocationCount, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "setPollBudget", &EventDispatcher::setPollBudget, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "getPollBudget", &EventDispatcher::getPollBudget, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "getLastPollTime", &EventDispatcher::getLastPollTime, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "getBudgetOverrunCount", &EventDispatcher::getBudgetOverrunCount, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "getDeferredEventCount", &EventDispatcher::getDeferredEventCount, &g_dispatcher);
 
     // ResourceManager
     g_lua.registerSingletonClass("g_resources");
@@ -176,6 +224,8 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_resources", "setupUserWriteDir", &ResourceManager::setupUserWriteDir, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "setWriteDir", &ResourceManager::setWriteDir, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "searchAndAddPackages", &ResourceManager::searchAndAddPackages, &g_resources);
+    g_lua.bindSingletonFunction("g_resources", "createPackage", &ResourceManager::createPackage, &g_resources);
+    g_lua.bindSingletonFunction("g_resources", "clearPathCache", &ResourceManager::clearPathCache, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "removeSearchPath", &ResourceManager::removeSearchPath, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "fileExists", &ResourceManager::fileExists, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "directoryExists", &ResourceManager::directoryExists, &g_resources);
@@ -225,9 +275,11 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<Module>("getAuthor", &Module::getAuthor);
     g_lua.bindClassMemberFunction<Module>("getWebsite", &Module::getWebsite);
     g_lua.bindClassMemberFunction<Module>("getVersion", &Module::getVersion);
+    g_lua.bindClassMemberFunction<Module>("getPath", &Module::getPath);
     g_lua.bindClassMemberFunction<Module>("getSandbox", &Module::getSandbox);
     g_lua.bindClassMemberFunction<Module>("isAutoLoad", &Module::isAutoLoad);
     g_lua.bindClassMemberFunction<Module>("getAutoLoadPriority", &Module::getAutoLoadPriority);
+    g_lua.bindClassMemberFunction<Module>("getLoadTime", &Module::getLoadTime);
 
     // Event
     g_lua.registerClass<Event>();
@@ -327,6 +379,7 @@ void Application::registerLuaFunctions()
     // UI
     g_lua.registerSingletonClass("g_ui");
     g_lua.bindSingletonFunction("g_ui", "clearStyles", &UIManager::clearStyles, &g_ui);
+    g_lua.bindSingletonFunction("g_ui", "clearDocumentCache", &UIManager::clearDocumentCache, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "importStyle", &UIManager::importStyle, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "getStyle", &UIManager::getStyle, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "getStyleClass", &UIManager::getStyleClass, &g_ui);
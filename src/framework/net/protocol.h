@@ -38,7 +38,7 @@ public:
     ~Protocol() override;
 
     void connect(const std::string& host, uint16 port);
-    void disconnect();
+    virtual void disconnect();
 
     bool isConnected();
     bool isConnecting();
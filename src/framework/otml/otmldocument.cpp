@@ -26,6 +26,43 @@
 
 #include <framework/core/resourcemanager.h>
 
+namespace
+{
+    constexpr uint32 COMPILED_SIGNATURE = 0x434D544F; // "OTMC"
+    constexpr uint32 COMPILED_VERSION = 1;
+
+    enum CompiledNodeFlags : uint8
+    {
+        CompiledNodeUnique = 1 << 0,
+        CompiledNodeNull = 1 << 1
+    };
+
+    template<typename T>
+    void appendValue(std::string& out, T value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    T readValue(const std::string& data, size_t& pos)
+    {
+        if(pos + sizeof(T) > data.size())
+            stdext::throw_exception("compiled document is truncated");
+        T value;
+        memcpy(&value, data.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    const std::string& readString(const std::vector<std::string>& strings, const std::string& data, size_t& pos)
+    {
+        const uint32 id = readValue<uint32>(data, pos);
+        if(id >= strings.size())
+            stdext::throw_exception("compiled document has an invalid string id");
+        return strings[id];
+    }
+}
+
 OTMLDocumentPtr OTMLDocument::create()
 {
     OTMLDocumentPtr doc(new OTMLDocument);
@@ -50,6 +87,111 @@ OTMLDocumentPtr OTMLDocument::parse(std::istream& in, const std::string& source)
     return doc;
 }
 
+OTMLDocumentPtr OTMLDocument::parseCached(const std::string& fileName)
+{
+    const std::string source = g_resources.resolvePath(fileName);
+    const std::string buffer = g_resources.readFileContents(source);
+    const std::string cacheFile = "/cache/otml" + source + "c";
+
+    std::string data;
+    if(g_resources.readCacheFile(cacheFile, COMPILED_SIGNATURE, COMPILED_VERSION, source, buffer, data)) {
+        try {
+            return decompile(data, 0);
+        } catch(std::exception& e) {
+            g_logger.warning(stdext::format("Discarding compiled otml '%s': %s", cacheFile, e.what()));
+        }
+    }
+
+    std::stringstream in(buffer);
+    OTMLDocumentPtr doc = parse(in, source);
+
+    if(!g_resources.getWriteDir().empty())
+        g_resources.writeCacheFile(cacheFile, COMPILED_SIGNATURE, COMPILED_VERSION, source, buffer, doc->compile());
+    return doc;
+}
+
+std::string OTMLDocument::compile()
+{
+    StringTable table;
+    std::string nodes;
+    compileNode(asOTMLNode(), table, nodes);
+
+    std::string out;
+    appendValue<uint32>(out, table.strings.size());
+    for(const std::string& str : table.strings) {
+        appendValue<uint32>(out, str.size());
+        out += str;
+    }
+    out += nodes;
+    return out;
+}
+
+void OTMLDocument::compileNode(const OTMLNodePtr& node, StringTable& table, std::string& out)
+{
+    const auto intern = [&table](const std::string& str) {
+        const auto it = table.ids.emplace(str, table.strings.size());
+        if(it.second)
+            table.strings.push_back(str);
+        return it.first->second;
+    };
+
+    uint8 flags = 0;
+    if(node->m_unique)
+        flags |= CompiledNodeUnique;
+    if(node->m_null)
+        flags |= CompiledNodeNull;
+
+    appendValue<uint32>(out, intern(node->m_tag));
+    appendValue<uint32>(out, intern(node->m_value));
+    appendValue<uint32>(out, intern(node->m_source));
+    appendValue<uint8>(out, flags);
+    appendValue<uint32>(out, node->m_children.size());
+    for(const OTMLNodePtr& child : node->m_children)
+        compileNode(child, table, out);
+}
+
+OTMLDocumentPtr OTMLDocument::decompile(const std::string& data, size_t pos)
+{
+    // every string takes at least its size, a larger count can only come from a corrupt file
+    const uint32 count = readValue<uint32>(data, pos);
+    if(count > (data.size() - pos) / sizeof(uint32))
+        stdext::throw_exception("compiled document has an invalid string count");
+
+    std::vector<std::string> strings(count);
+    for(std::string& str : strings) {
+        const uint32 size = readValue<uint32>(data, pos);
+        if(pos + size > data.size())
+            stdext::throw_exception("compiled document is truncated");
+        str.assign(data, pos, size);
+        pos += size;
+    }
+
+    OTMLDocumentPtr doc(new OTMLDocument);
+    decompileNode(doc, strings, data, pos);
+    if(pos != data.size())
+        stdext::throw_exception("compiled document has trailing data");
+    return doc;
+}
+
+void OTMLDocument::decompileNode(const OTMLNodePtr& node, const std::vector<std::string>& strings, const std::string& data, size_t& pos)
+{
+    node->m_tag = readString(strings, data, pos);
+    node->m_value = readString(strings, data, pos);
+    node->m_source = readString(strings, data, pos);
+    const uint8 flags = readValue<uint8>(data, pos);
+    node->m_unique = flags & CompiledNodeUnique;
+    node->m_null = flags & CompiledNodeNull;
+
+    // children are restored as they were stored, unique tags were already resolved by the parser
+    const uint32 count = readValue<uint32>(data, pos);
+    node->m_children.reserve(std::min<uint32>(count, data.size() - pos));
+    for(uint32 i = 0; i < count; ++i) {
+        OTMLNodePtr child(new OTMLNode);
+        decompileNode(child, strings, data, pos);
+        node->m_children.push_back(child);
+    }
+}
+
 std::string OTMLDocument::emit()
 {
     return OTMLEmitter::emitNode(asOTMLNode()) + "\n";
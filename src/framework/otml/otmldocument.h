@@ -40,6 +40,10 @@ public:
     /// @param source is the file name that will be used to show errors messages
     static OTMLDocumentPtr parse(std::istream& in, const std::string& source);
 
+    /// Parse OTML from a file, reusing its compiled form from /cache/otml in the write dir
+    /// while the file modification time, size and checksum are unchanged
+    static OTMLDocumentPtr parseCached(const std::string& fileName);
+
     /// Emits this document and all it's children to a std::string
     std::string emit() override;
 
@@ -48,6 +52,18 @@ public:
 
 private:
     OTMLDocument() = default;
+
+    struct StringTable
+    {
+        std::unordered_map<std::string, uint32> ids;
+        std::vector<std::string> strings;
+    };
+
+    /// Binary form of the document, tags, values and sources are interned in a string table
+    std::string compile();
+    static OTMLDocumentPtr decompile(const std::string& data, size_t pos);
+    static void compileNode(const OTMLNodePtr& node, StringTable& table, std::string& out);
+    static void decompileNode(const OTMLNodePtr& node, const std::vector<std::string>& strings, const std::string& data, size_t& pos);
 };
 
 #endif
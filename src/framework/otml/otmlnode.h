@@ -100,6 +100,8 @@ protected:
     std::string m_source;
     bool m_unique{ false };
     bool m_null{ false };
+
+    friend class OTMLDocument;
 };
 
 #include "otmlexception.h"
@@ -43,6 +43,7 @@
 #include <functional>
 #include <array>
 #include <unordered_map>
+#include <unordered_set>
 #include <tuple>
 #include <iomanip>
 #include <typeinfo>
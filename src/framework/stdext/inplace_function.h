@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2010-2020 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef STDEXT_INPLACE_FUNCTION_H
+#define STDEXT_INPLACE_FUNCTION_H
+
+#include "types.h"
+#include <atomic>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace stdext {
+    // move only replacement of std::function that keeps the callable inside an inline buffer,
+    // only callables that are bigger than the buffer are allocated in the heap
+    template<typename Signature, std::size_t Capacity = 48>
+    class inplace_function;
+
+    // number of callables that did not fit an inline buffer, shared by all signatures
+    inline std::atomic<uint64> inplace_function_heap_allocations{ 0 };
+
+    template<typename Ret, typename... Args, std::size_t Capacity>
+    class inplace_function<Ret(Args...), Capacity>
+    {
+    public:
+        inplace_function() = default;
+        inplace_function(std::nullptr_t) {}
+
+        template<typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, inplace_function>::value>::type>
+        inplace_function(F&& f) { assign(std::forward<F>(f)); }
+
+        inplace_function(inplace_function&& other) noexcept { moveFrom(other); }
+        inplace_function(const inplace_function&) = delete;
+        ~inplace_function() { reset(); }
+
+        inplace_function& operator=(inplace_function&& other) noexcept
+        {
+            if(this != &other) {
+                reset();
+                moveFrom(other);
+            }
+            return *this;
+        }
+        inplace_function& operator=(const inplace_function&) = delete;
+        inplace_function& operator=(std::nullptr_t) { reset(); return *this; }
+
+        Ret operator()(Args... args) { return m_ops->invoke(&m_storage, std::forward<Args>(args)...); }
+        explicit operator bool() const { return m_ops != nullptr; }
+
+        void reset()
+        {
+            if(m_ops) {
+                m_ops->destroy(&m_storage);
+                m_ops = nullptr;
+            }
+        }
+
+    private:
+        struct ops {
+            Ret(*invoke)(void* storage, Args&&... args);
+            void(*move)(void* dest, void* src);
+            void(*destroy)(void* storage);
+        };
+
+        template<typename F>
+        static constexpr bool fits_inline()
+        {
+            return sizeof(F) <= Capacity && alignof(F) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible<F>::value;
+        }
+
+        template<typename F>
+        static bool is_null(const F& f)
+        {
+            if constexpr(std::is_pointer<F>::value || std::is_member_pointer<F>::value)
+                return f == nullptr;
+            else
+                return is_null_function(f);
+        }
+        template<typename F>
+        static bool is_null_function(const F&) { return false; }
+        template<typename Sig>
+        static bool is_null_function(const std::function<Sig>& f) { return !f; }
+
+        template<typename F>
+        void assign(F&& f)
+        {
+            using Functor = typename std::decay<F>::type;
+            if(is_null(f))
+                return;
+
+            if constexpr(fits_inline<Functor>()) {
+                static const ops inlineOps = {
+                    [](void* storage, Args&&... args) -> Ret { return (*static_cast<Functor*>(storage))(std::forward<Args>(args)...); },
+                    [](void* dest, void* src) {
+                        new (dest) Functor(std::move(*static_cast<Functor*>(src)));
+                        static_cast<Functor*>(src)->~Functor();
+                    },
+                    [](void* storage) { static_cast<Functor*>(storage)->~Functor(); }
+                };
+                new (&m_storage) Functor(std::forward<F>(f));
+                m_ops = &inlineOps;
+            } else {
+                static const ops heapOps = {
+                    [](void* storage, Args&&... args) -> Ret { return (**static_cast<Functor**>(storage))(std::forward<Args>(args)...); },
+                    [](void* dest, void* src) { *static_cast<Functor**>(dest) = *static_cast<Functor**>(src); },
+                    [](void* storage) { delete *static_cast<Functor**>(storage); }
+                };
+                *reinterpret_cast<Functor**>(&m_storage) = new Functor(std::forward<F>(f));
+                m_ops = &heapOps;
+                inplace_function_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        void moveFrom(inplace_function& other)
+        {
+            if(other.m_ops) {
+                other.m_ops->move(&m_storage, &other.m_storage);
+                m_ops = other.m_ops;
+                other.m_ops = nullptr;
+            }
+        }
+
+        typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type m_storage;
+        const ops* m_ops{ nullptr };
+    };
+}
+
+#endif
@@ -31,6 +31,7 @@
 #include "dynamic_storage.h"
 #include "exception.h"
 #include "format.h"
+#include "inplace_function.h"
 #include "math.h"
 #include "net.h"
 #include "packed_any.h"
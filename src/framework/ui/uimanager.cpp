@@ -27,6 +27,7 @@
 #include <framework/graphics/graphics.h>
 #include <framework/platform/platformwindow.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/core/profiler.h>
 #include <framework/core/application.h>
 #include <framework/core/resourcemanager.h>
 
@@ -52,12 +53,14 @@ void UIManager::terminate()
     m_hoveredWidget = nullptr;
     m_pressedWidget = nullptr;
     m_styles.clear();
+    m_documents.clear();
     m_destroyedWidgets.clear();
     m_checkEvent = nullptr;
 }
 
 void UIManager::render(Fw::DrawPane drawPane)
 {
+    PROFILE_SCOPE("ui render");
     m_rootWidget->draw(m_rootWidget->getRect(), drawPane);
 }
 
@@ -320,7 +323,7 @@ bool UIManager::importStyle(std::string file)
     try {
         file = g_resources.guessFilePath(file, "otui");
 
-        OTMLDocumentPtr doc = OTMLDocument::parse(file);
+        OTMLDocumentPtr doc = loadDocument(file);
 
         for(const OTMLNodePtr& styleNode : doc->children())
             importStyleFromOTML(styleNode);
@@ -331,8 +334,9 @@ bool UIManager::importStyle(std::string file)
     }
 }
 
-void UIManager::importStyleFromOTML(const OTMLNodePtr& styleNode)
+void UIManager::importStyleFromOTML(const OTMLNodePtr& node)
 {
+    OTMLNodePtr styleNode = node;
     const std::string tag = styleNode->tag();
     std::vector<std::string> split = stdext::split(tag, "<");
     if(split.size() != 2)
@@ -349,6 +353,8 @@ void UIManager::importStyleFromOTML(const OTMLNodePtr& styleNode)
         name = name.substr(1);
         unique = true;
 
+        // the node may belong to a cached document
+        styleNode = styleNode->clone();
         styleNode->setTag(name);
         styleNode->writeAt("__unique", true);
     }
@@ -400,12 +406,24 @@ std::string UIManager::getStyleClass(const std::string& styleName)
     return "";
 }
 
+OTMLDocumentPtr UIManager::loadDocument(const std::string& file)
+{
+    const ticks_t fileTime = g_resources.getFileTime(file);
+    const auto it = m_documents.find(file);
+    if(it != m_documents.end() && it->second.fileTime == fileTime)
+        return it->second.document;
+
+    OTMLDocumentPtr doc = OTMLDocument::parseCached(file);
+    m_documents[file] = { doc, fileTime };
+    return doc;
+}
+
 UIWidgetPtr UIManager::loadUI(std::string file, const UIWidgetPtr& parent)
 {
     try {
         file = g_resources.guessFilePath(file, "otui");
 
-        OTMLDocumentPtr doc = OTMLDocument::parse(file);
+        OTMLDocumentPtr doc = loadDocument(file);
         UIWidgetPtr widget;
         for(const OTMLNodePtr& node : doc->children()) {
             std::string tag = node->tag();
@@ -45,10 +45,14 @@ public:
 
     void clearStyles();
     bool importStyle(std::string file);
-    void importStyleFromOTML(const OTMLNodePtr& styleNode);
+    void importStyleFromOTML(const OTMLNodePtr& node);
     OTMLNodePtr getStyle(const std::string& styleName);
     std::string getStyleClass(const std::string& styleName);
 
+    /// Parsed otui documents are kept in memory and reused while their file is unchanged,
+    /// callers must not modify the returned document
+    OTMLDocumentPtr loadDocument(const std::string& file);
+    void clearDocumentCache() { m_documents.clear(); }
     UIWidgetPtr loadUI(std::string file, const UIWidgetPtr& parent);
     UIWidgetPtr displayUI(const std::string& file) { return loadUI(file, m_rootWidget); }
     UIWidgetPtr createWidget(const std::string& styleName, const UIWidgetPtr& parent);
@@ -87,6 +91,13 @@ private:
     bool m_hoverUpdateScheduled{ false },
         m_drawDebugBoxes{ false };
     std::unordered_map<std::string, OTMLNodePtr> m_styles;
+
+    struct CachedDocument
+    {
+        OTMLDocumentPtr document;
+        ticks_t fileTime;
+    };
+    std::unordered_map<std::string, CachedDocument> m_documents;
     UIWidgetList m_destroyedWidgets;
     ScheduledEventPtr m_checkEvent;
 };
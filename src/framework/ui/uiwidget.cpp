@@ -1494,14 +1494,16 @@ void UIWidget::onGeometryChange(const Rect& oldRect, const Rect& newRect)
             child->bindRectToParent();
     }
 
-    callLuaField("onGeometryChange", oldRect, newRect);
+    static const LuaFieldKey field("onGeometryChange");
+    callLuaField(field, oldRect, newRect);
 
     g_app.repaint();
 }
 
 void UIWidget::onLayoutUpdate()
 {
-    callLuaField("onLayoutUpdate");
+    static const LuaFieldKey field("onLayoutUpdate");
+    callLuaField(field);
 }
 
 void UIWidget::onFocusChange(bool focused, Fw::FocusReason reason)
@@ -1516,7 +1518,8 @@ void UIWidget::onChildFocusChange(const UIWidgetPtr& focusedChild, const UIWidge
 
 void UIWidget::onHoverChange(bool hovered)
 {
-    callLuaField("onHoverChange", hovered);
+    static const LuaFieldKey field("onHoverChange");
+    callLuaField(field, hovered);
 }
 
 void UIWidget::onVisibilityChange(bool visible)
@@ -1538,7 +1541,8 @@ bool UIWidget::onDragLeave(UIWidgetPtr droppedWidget, const Point& mousePos)
 
 bool UIWidget::onDragMove(const Point& mousePos, const Point& mouseMoved)
 {
-    return callLuaField<bool>("onDragMove", mousePos, mouseMoved);
+    static const LuaFieldKey field("onDragMove");
+    return callLuaField<bool>(field, mousePos, mouseMoved);
 }
 
 bool UIWidget::onDrop(UIWidgetPtr draggedWidget, const Point& mousePos)
@@ -1588,7 +1592,8 @@ bool UIWidget::onMouseRelease(const Point& mousePos, Fw::MouseButton button)
 
 bool UIWidget::onMouseMove(const Point& mousePos, const Point& mouseMoved)
 {
-    return callLuaField<bool>("onMouseMove", mousePos, mouseMoved);
+    static const LuaFieldKey field("onMouseMove");
+    return callLuaField<bool>(field, mousePos, mouseMoved);
 }
 
 bool UIWidget::onMouseWheel(const Point& mousePos, Fw::MouseWheelDirection direction)